@@ -15,14 +15,29 @@
  */
 #include "cfam_access.hpp"
 
+#include "cfam_arbitration.hpp"
+#include "cfam_engine.hpp"
+#include "cfam_recorder.hpp"
+#include "cfam_retry.hpp"
 #include "targeting.hpp"
+#include "tracing.hpp"
 
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <xyz/openbmc_project/Common/Device/error.hpp>
 #include <xyz/openbmc_project/Common/File/error.hpp>
+#include <xyz/openbmc_project/Common/error.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <thread>
 
 namespace openpower
 {
@@ -35,94 +50,1197 @@ constexpr auto cfamRegSize = 4;
 
 using namespace openpower::targeting;
 using namespace openpower::util;
+using openpower::cfam::recorder::Recorder;
 namespace file_error = sdbusplus::xyz::openbmc_project::Common::File::Error;
 namespace device_error = sdbusplus::xyz::openbmc_project::Common::Device::Error;
 
 /**
- * Converts the CFAM register address used by the calling
- * code (because that's how it is in the spec) to the address
- * required by the device driver.
+ * Returns the failure of an access
  */
-static inline cfam_address_t makeOffset(cfam_address_t address)
+static AccessError makeError(const Target& target, AccessError::Step step,
+                             cfam_address_t address, cfam_address_t offset,
+                             int err)
 {
-    return (address & 0xFC00) | ((address & 0x03FF) << 2);
+    return {step, err, target.getPos(), target.getCFAMPath(), address, offset};
 }
 
-void writeReg(const std::unique_ptr<Target>& target, cfam_address_t address,
-              cfam_data_t data)
+void throwError(const AccessError& error)
 {
     using namespace phosphor::logging;
-    int rc = lseek(target->getCFAMFD(), makeOffset(address), SEEK_SET);
-    if (rc < 0)
+
+    if (error.step == AccessError::Step::open)
     {
-        log<level::ERR>("Failed seeking on a processor CFAM",
-                        entry("CFAM_ADDRESS=0x%X", address));
+        using metadata = xyz::openbmc_project::Common::File::Open;
+
+        elog<file_error::Open>(metadata::ERRNO(error.error),
+                               metadata::PATH(error.path.c_str()));
+    }
 
-        using metadata = xyz::openbmc_project::Common::File::Seek;
+    if (error.step == AccessError::Step::read)
+    {
+        using metadata = xyz::openbmc_project::Common::Device::ReadFailure;
 
-        elog<file_error::Seek>(metadata::OFFSET(makeOffset(address)),
-                               metadata::WHENCE(SEEK_SET),
-                               metadata::ERRNO(errno),
-                               metadata::PATH(target->getCFAMPath().c_str()));
+        elog<device_error::ReadFailure>(
+            metadata::CALLOUT_ERRNO(error.error),
+            metadata::CALLOUT_DEVICE_PATH(error.path.c_str()));
     }
 
-    data = htobe32(data);
+    using metadata = xyz::openbmc_project::Common::Device::WriteFailure;
+
+    elog<device_error::WriteFailure>(
+        metadata::CALLOUT_ERRNO(error.error),
+        metadata::CALLOUT_DEVICE_PATH(error.path.c_str()));
+}
+
+void ErrorSummary::logSummary(const char* procedure) const
+{
+    using namespace phosphor::logging;
 
-    rc = write(target->getCFAMFD(), &data, cfamRegSize);
-    if (rc < 0)
+    if (errors.empty())
     {
-        using metadata = xyz::openbmc_project::Common::Device::WriteFailure;
+        return;
+    }
 
-        elog<device_error::WriteFailure>(
-            metadata::CALLOUT_ERRNO(errno),
-            metadata::CALLOUT_DEVICE_PATH(target->getCFAMPath().c_str()));
+    static constexpr const char* steps[] = {"open", "read", "write"};
+
+    std::string failures;
+    for (const auto& error : errors)
+    {
+        char failure[64];
+        snprintf(failure, sizeof(failure), "%sP%zu 0x%04X %s errno %d",
+                 failures.empty() ? "" : ", ", error.target, error.address,
+                 steps[static_cast<int>(error.step)], error.error);
+        failures += failure;
     }
+
+    log<level::ERR>("CFAM accesses failed", entry("PROCEDURE=%s", procedure),
+                    entry("COUNT=%zu", errors.size()),
+                    entry("FAILURES=%s", failures.c_str()),
+                    entry("PATH=%s", errors.front().path.c_str()));
 }
 
-cfam_data_t readReg(const std::unique_ptr<Target>& target,
-                    cfam_address_t address)
+/**
+ * Adds an access to the target's statistics, and to the
+ * recording if recording is on.  The statistics only get the
+ * latency of the last attempt, which started at attemptStart, as
+ * the failed ones were counted when they were retried.
+ */
+static inline void record(Target& target, recorder::Type type,
+                          cfam_address_t address, cfam_data_t data,
+                          cfam_mask_t mask, int err,
+                          std::chrono::steady_clock::time_point start,
+                          std::chrono::steady_clock::time_point attemptStart)
+{
+    auto now = std::chrono::steady_clock::now();
+    auto latency = now - start;
+
+    target.getStats().record(type, err, now - attemptStart);
+
+    OPENPOWER_PROBE(
+        cfam__access__done, target.getPos(), static_cast<int>(type), address,
+        data, err,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+
+    auto recorder = Recorder::get();
+    if (recorder)
+    {
+        recorder->record(target.getPos(), type, address, data, mask, err,
+                         start);
+    }
+}
+
+/**
+ * Waits for other processes to finish with the target, if arbitration
+ * is on, and adds the wait to the target's statistics.
+ */
+static std::optional<arbitration::Lock> lock(Target& target)
+{
+    auto held = arbitration::acquire(target.getPos());
+    if (held)
+    {
+        target.getStats().recordLockWait(held->getWait());
+    }
+
+    return held;
+}
+
+/**
+ * Retries a failed access with the retry policy, counting each
+ * retry, and the latency of the attempt that failed, in the
+ * target's statistics.
+ *
+ * @param[in] err - 0, or the errno of the access that was done
+ * @param[in] access - Does the access again, returning 0 or the errno
+ * @param[in,out] attemptStart - When the access that was done
+ *                               started, then when the last retry did
+ *
+ * @return 0 on success, else the errno of the last try
+ */
+template <typename Access>
+static int retryAccess(Target& target, recorder::Type type,
+                       cfam_address_t address, int err, Access&& access,
+                       std::chrono::steady_clock::time_point& attemptStart)
 {
     using namespace phosphor::logging;
 
+    auto attempt = [&]() {
+        attemptStart = std::chrono::steady_clock::now();
+        return access();
+    };
+
+    return retry::run(err, attempt, [&](int failure, unsigned retry) {
+        target.getStats().recordRetry(
+            type, failure, std::chrono::steady_clock::now() - attemptStart);
+        OPENPOWER_PROBE(cfam__retry, target.getPos(), static_cast<int>(type),
+                        address, failure, retry);
+        log<level::INFO>("Retrying a failed CFAM access",
+                         entry("POSITION=%zu", target.getPos()),
+                         entry("CFAM_ADDRESS=0x%X", address),
+                         entry("TYPE=%d", static_cast<int>(type)),
+                         entry("ERRNO=%d", failure), entry("RETRY=%u", retry));
+    });
+}
+
+/**
+ * Reads a register through the target's backend, unless the
+ * shadow cache already has its value.
+ *
+ * @return 0 on success, else the errno
+ */
+static int readRaw(Target& target, cfam_address_t address,
+                   cfam_address_t offset, cfam_data_t& data)
+{
+    auto cached = target.getCachedReg(address);
+    if (cached)
+    {
+        data = *cached;
+        return 0;
+    }
+
+    auto err = target.getBackend().read(address, offset, data);
+    if (err)
+    {
+        target.invalidateCache();
+        return err;
+    }
+
+    target.updateCachedReg(address, data);
+    return 0;
+}
+
+/**
+ * Writes a register through the target's backend.
+ *
+ * @return 0 on success, else the errno
+ */
+static int writeRaw(Target& target, cfam_address_t address,
+                    cfam_address_t offset, cfam_data_t data)
+{
+    auto err = target.getBackend().write(address, offset, data);
+    if (err)
+    {
+        target.invalidateCache();
+        return err;
+    }
+
+    target.updateCachedReg(address, data);
+    return 0;
+}
+
+/**
+ * Does a read-modify-write of the bits in the mask.  If the register
+ * value is cached the read is skipped, and so is the write if it
+ * wouldn't change anything.
+ *
+ * @param[out] value - The full register value written
+ * @param[out] readFailed - Set if it was the read that failed
+ *
+ * @return 0 on success, else the errno
+ */
+static int modifyRaw(Target& target, cfam_address_t address,
+                     cfam_address_t offset, cfam_data_t data, cfam_mask_t mask,
+                     cfam_data_t& value, bool& readFailed)
+{
+    auto cached = target.getCachedReg(address);
+
+    readFailed = false;
+
+    if (cached)
+    {
+        value = *cached;
+    }
+    else
+    {
+        auto err = readRaw(target, address, offset, value);
+        if (err)
+        {
+            readFailed = true;
+            return err;
+        }
+    }
+
+    cfam_data_t newValue = (value & ~mask) | (data & mask);
+    if (cached && (newValue == value))
+    {
+        return 0;
+    }
+
+    value = newValue;
+    return writeRaw(target, address, offset, value);
+}
+
+namespace detail
+{
+
+std::expected<cfam_data_t, AccessError>
+    tryWriteReg(const std::unique_ptr<Target>& target, cfam_address_t address,
+                cfam_address_t offset, cfam_data_t data)
+{
+    auto held = lock(*target);
+    auto start = std::chrono::steady_clock::now();
+    OPENPOWER_PROBE(cfam__access__start, target->getPos(),
+                    static_cast<int>(recorder::Type::write), address);
+
+    auto step = AccessError::Step::open;
+    auto access = [&]() {
+        step = AccessError::Step::open;
+        auto err = target->openCFAM();
+        if (err)
+        {
+            return err;
+        }
+
+        step = AccessError::Step::write;
+        return writeRaw(*target, address, offset, data);
+    };
+
+    auto attemptStart = start;
+    auto err = retryAccess(*target, recorder::Type::write, address, access(),
+                           access, attemptStart);
+    record(*target, recorder::Type::write, address, data, 0, err, start,
+           attemptStart);
+    if (err)
+    {
+        return std::unexpected(
+            makeError(*target, step, address, offset, err));
+    }
+
+    return data;
+}
+
+std::expected<cfam_data_t, AccessError>
+    tryReadReg(const std::unique_ptr<Target>& target, cfam_address_t address,
+               cfam_address_t offset)
+{
     cfam_data_t data = 0;
+    auto held = lock(*target);
+    auto start = std::chrono::steady_clock::now();
+    OPENPOWER_PROBE(cfam__access__start, target->getPos(),
+                    static_cast<int>(recorder::Type::read), address);
+
+    auto step = AccessError::Step::open;
+    auto access = [&]() {
+        step = AccessError::Step::open;
+        auto err = target->openCFAM();
+        if (err)
+        {
+            return err;
+        }
 
-    int rc = lseek(target->getCFAMFD(), makeOffset(address), SEEK_SET);
-    if (rc < 0)
+        step = AccessError::Step::read;
+        return readRaw(*target, address, offset, data);
+    };
+
+    auto attemptStart = start;
+    auto err = retryAccess(*target, recorder::Type::read, address, access(),
+                           access, attemptStart);
+    record(*target, recorder::Type::read, address, data, 0, err, start,
+           attemptStart);
+    if (err)
     {
-        log<level::ERR>("Failed seeking on a processor CFAM",
-                        entry("CFAM_ADDRESS=0x%X", address));
+        return std::unexpected(
+            makeError(*target, step, address, offset, err));
+    }
+
+    return data;
+}
+
+std::expected<cfam_data_t, AccessError>
+    tryWriteRegWithMask(const std::unique_ptr<Target>& target,
+                        cfam_address_t address, cfam_address_t offset,
+                        cfam_data_t data, cfam_mask_t mask)
+{
+    cfam_data_t value = 0;
+    auto held = lock(*target);
+    auto start = std::chrono::steady_clock::now();
+    OPENPOWER_PROBE(cfam__access__start, target->getPos(),
+                    static_cast<int>(recorder::Type::writeWithMask), address);
 
-        using metadata = xyz::openbmc_project::Common::File::Seek;
+    auto step = AccessError::Step::open;
+    auto access = [&]() {
+        step = AccessError::Step::open;
+        auto err = target->openCFAM();
+        if (err)
+        {
+            return err;
+        }
 
-        elog<file_error::Seek>(metadata::OFFSET(makeOffset(address)),
-                               metadata::WHENCE(SEEK_SET),
-                               metadata::ERRNO(errno),
-                               metadata::PATH(target->getCFAMPath().c_str()));
+        bool readFailed = false;
+        err = modifyRaw(*target, address, offset, data, mask, value,
+                        readFailed);
+        step = readFailed ? AccessError::Step::read
+                          : AccessError::Step::write;
+        return err;
+    };
+
+    auto attemptStart = start;
+    auto err = retryAccess(*target, recorder::Type::writeWithMask, address,
+                           access(), access, attemptStart);
+    record(*target, recorder::Type::writeWithMask, address, data, mask, err,
+           start, attemptStart);
+    if (err)
+    {
+        return std::unexpected(
+            makeError(*target, step, address, offset, err));
     }
 
-    rc = read(target->getCFAMFD(), &data, cfamRegSize);
-    if (rc < 0)
+    return value;
+}
+
+void writeReg(const std::unique_ptr<Target>& target, cfam_address_t address,
+              cfam_address_t offset, cfam_data_t data)
+{
+    auto result = tryWriteReg(target, address, offset, data);
+    if (!result)
     {
-        using metadata = xyz::openbmc_project::Common::Device::ReadFailure;
+        throwError(result.error());
+    }
+}
 
-        elog<device_error::ReadFailure>(
-            metadata::CALLOUT_ERRNO(errno),
-            metadata::CALLOUT_DEVICE_PATH(target->getCFAMPath().c_str()));
+cfam_data_t readReg(const std::unique_ptr<Target>& target,
+                    cfam_address_t address, cfam_address_t offset)
+{
+    auto result = tryReadReg(target, address, offset);
+    if (!result)
+    {
+        throwError(result.error());
     }
 
-    return be32toh(data);
+    return *result;
+}
+
+void writeRegWithMask(const std::unique_ptr<Target>& target,
+                      cfam_address_t address, cfam_address_t offset,
+                      cfam_data_t data, cfam_mask_t mask)
+{
+    auto result = tryWriteRegWithMask(target, address, offset, data, mask);
+    if (!result)
+    {
+        throwError(result.error());
+    }
+}
+
+std::expected<WaitResult, AccessError>
+    tryWaitForReg(const std::unique_ptr<Target>& target,
+                  cfam_address_t address, cfam_address_t offset,
+                  cfam_mask_t mask, cfam_data_t expected,
+                  std::chrono::steady_clock::time_point deadline)
+{
+    using namespace std::chrono;
+
+    // Polls that aren't worth sleeping between, as the hardware
+    // is often done by the time the first few reads are.
+    constexpr size_t spinPolls = 8;
+    constexpr auto firstSleep = microseconds(10);
+    constexpr auto maxSleep = milliseconds(10);
+
+    WaitResult result;
+    auto start = steady_clock::now();
+    steady_clock::duration sleep = firstSleep;
+
+    while (true)
+    {
+        auto step = AccessError::Step::open;
+        int err = 0;
+        {
+            // Held for each poll, so other processes get the chip
+            // while this one sleeps.
+            auto held = lock(*target);
+            auto pollStart = steady_clock::now();
+            auto attemptStart = pollStart;
+            auto read = [&]() {
+                step = AccessError::Step::open;
+                auto rc = target->openCFAM();
+                if (rc)
+                {
+                    return rc;
+                }
+
+                step = AccessError::Step::read;
+                return target->getBackend().read(address, offset,
+                                                 result.data);
+            };
+            err = retryAccess(*target, recorder::Type::read, address, read(),
+                              read, attemptStart);
+            record(*target, recorder::Type::read, address, result.data, 0,
+                   err, pollStart, attemptStart);
+        }
+        result.polls++;
+        if (err)
+        {
+            target->invalidateCache();
+            return std::unexpected(
+                makeError(*target, step, address, offset, err));
+        }
+
+        auto now = steady_clock::now();
+        result.elapsed = duration_cast<microseconds>(now - start);
+
+        if ((result.data & mask) == (expected & mask))
+        {
+            result.matched = true;
+            break;
+        }
+
+        if (now >= deadline)
+        {
+            break;
+        }
+
+        if (result.polls < spinPolls)
+        {
+            continue;
+        }
+
+        std::this_thread::sleep_for(std::min(sleep, deadline - now));
+        sleep = std::min<steady_clock::duration>(sleep * 2, maxSleep);
+    }
+
+    target->updateCachedReg(address, result.data);
+    return result;
+}
+
+WaitResult waitForReg(const std::unique_ptr<Target>& target,
+                      cfam_address_t address, cfam_address_t offset,
+                      cfam_mask_t mask, cfam_data_t expected,
+                      std::chrono::steady_clock::time_point deadline)
+{
+    auto result = tryWaitForReg(target, address, offset, mask, expected,
+                                deadline);
+    if (!result)
+    {
+        throwError(result.error());
+    }
+
+    return *result;
+}
+
+} // namespace detail
+
+void writeReg(const std::unique_ptr<Target>& target, cfam_address_t address,
+              cfam_data_t data)
+{
+    detail::writeReg(target, address, makeOffset(address), data);
+}
+
+cfam_data_t readReg(const std::unique_ptr<Target>& target,
+                    cfam_address_t address)
+{
+    return detail::readReg(target, address, makeOffset(address));
 }
 
 void writeRegWithMask(const std::unique_ptr<Target>& target,
                       cfam_address_t address, cfam_data_t data,
                       cfam_mask_t mask)
 {
-    cfam_data_t readData = readReg(target, address);
+    detail::writeRegWithMask(target, address, makeOffset(address), data,
+                             mask);
+}
+
+std::expected<cfam_data_t, AccessError>
+    tryWriteReg(const std::unique_ptr<Target>& target, cfam_address_t address,
+                cfam_data_t data)
+{
+    return detail::tryWriteReg(target, address, makeOffset(address), data);
+}
+
+std::expected<cfam_data_t, AccessError>
+    tryReadReg(const std::unique_ptr<Target>& target, cfam_address_t address)
+{
+    return detail::tryReadReg(target, address, makeOffset(address));
+}
+
+std::expected<cfam_data_t, AccessError>
+    tryWriteRegWithMask(const std::unique_ptr<Target>& target,
+                        cfam_address_t address, cfam_data_t data,
+                        cfam_mask_t mask)
+{
+    return detail::tryWriteRegWithMask(target, address, makeOffset(address),
+                                       data, mask);
+}
+
+std::vector<cfam_data_t> readRange(const std::unique_ptr<Target>& target,
+                                   cfam_address_t address, size_t count)
+{
+    Batch batch{Batch::Policy::stopOnError};
+    auto first = batch.readRange(target, address, count);
+    batch.submit();
+    batch.check();
+
+    std::vector<cfam_data_t> data(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        data[i] = batch.result(first + i).data;
+    }
+
+    return data;
+}
+
+void writeRange(const std::unique_ptr<Target>& target, cfam_address_t address,
+                const std::vector<cfam_data_t>& data)
+{
+    Batch batch{Batch::Policy::stopOnError};
+    batch.writeRange(target, address, data);
+    batch.submit();
+    batch.check();
+}
+
+WaitResult waitForReg(const std::unique_ptr<Target>& target,
+                      cfam_address_t address, cfam_mask_t mask,
+                      cfam_data_t expected,
+                      std::chrono::steady_clock::time_point deadline)
+{
+    return detail::waitForReg(target, address, makeOffset(address), mask,
+                              expected, deadline);
+}
+
+std::expected<WaitResult, AccessError>
+    tryWaitForReg(const std::unique_ptr<Target>& target,
+                  cfam_address_t address, cfam_mask_t mask,
+                  cfam_data_t expected,
+                  std::chrono::steady_clock::time_point deadline)
+{
+    return detail::tryWaitForReg(target, address, makeOffset(address), mask,
+                                 expected, deadline);
+}
+
+namespace detail
+{
+
+BroadcastResult broadcast(
+    Targeting& targets, Batch::Policy policy,
+    const std::function<size_t(Batch&, const std::unique_ptr<Target>&)>&
+        queue)
+{
+    // Back to back operations on different Targets are one wave
+    Batch batch{policy};
+    std::vector<std::pair<size_t, size_t>> ids;
+    for (const auto& target : targets)
+    {
+        ids.emplace_back(target->getPos(), queue(batch, target));
+    }
+    batch.submit();
+
+    if (policy == Batch::Policy::stopOnError)
+    {
+        batch.check();
+    }
+
+    BroadcastResult results;
+    for (const auto& [pos, id] : ids)
+    {
+        results.emplace(pos, batch.value(id));
+    }
+
+    return results;
+}
+
+} // namespace detail
+
+BroadcastResult broadcastWrite(Targeting& targets, cfam_address_t address,
+                               cfam_data_t data, Batch::Policy policy)
+{
+    return detail::broadcast(
+        targets, policy,
+        [address, data](Batch& batch, const std::unique_ptr<Target>& t) {
+            return batch.write(t, address, data);
+        });
+}
+
+BroadcastResult broadcastWriteWithMask(Targeting& targets,
+                                       cfam_address_t address,
+                                       cfam_data_t data, cfam_mask_t mask,
+                                       Batch::Policy policy)
+{
+    return detail::broadcast(
+        targets, policy,
+        [address, data, mask](Batch& batch,
+                              const std::unique_ptr<Target>& t) {
+            return batch.writeWithMask(t, address, data, mask);
+        });
+}
+
+recorder::Type Batch::toRecordType(Type type)
+{
+    switch (type)
+    {
+        case Type::write:
+            return recorder::Type::write;
+        case Type::writeWithMask:
+            return recorder::Type::writeWithMask;
+        default:
+            return recorder::Type::read;
+    }
+}
+
+size_t Batch::queue(const std::unique_ptr<Target>& target,
+                    cfam_address_t address, cfam_address_t offset,
+                    cfam_data_t data, cfam_mask_t mask, Type type)
+{
+    ops.push_back({target.get(), address, offset, data, mask, type,
+                   Access::read, {}, {}});
+    return ops.size() - 1;
+}
+
+size_t Batch::read(const std::unique_ptr<Target>& target,
+                   cfam_address_t address)
+{
+    return queue(target, address, makeOffset(address), 0, 0, Type::read);
+}
+
+size_t Batch::write(const std::unique_ptr<Target>& target,
+                    cfam_address_t address, cfam_data_t data)
+{
+    return queue(target, address, makeOffset(address), data, 0, Type::write);
+}
+
+size_t Batch::writeWithMask(const std::unique_ptr<Target>& target,
+                            cfam_address_t address, cfam_data_t data,
+                            cfam_mask_t mask)
+{
+    return queue(target, address, makeOffset(address), data, mask,
+                 Type::writeWithMask);
+}
+
+/**
+ * Throws if a range of registers goes past the last address
+ */
+static void checkRange(cfam_address_t address, size_t count)
+{
+    if (address + count > 0x10000)
+    {
+        namespace error = sdbusplus::xyz::openbmc_project::Common::Error;
+        namespace metadata = phosphor::logging::xyz::openbmc_project::Common;
+
+        auto value = std::to_string(count);
+        phosphor::logging::elog<error::InvalidArgument>(
+            metadata::InvalidArgument::ARGUMENT_NAME("count"),
+            metadata::InvalidArgument::ARGUMENT_VALUE(value.c_str()));
+    }
+}
+
+size_t Batch::readRange(const std::unique_ptr<Target>& target,
+                        cfam_address_t address, size_t count)
+{
+    checkRange(address, count);
+
+    // Reads of neighboring registers are coalesced when submitted
+    size_t first = ops.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        read(target, address + i);
+    }
+
+    return first;
+}
+
+size_t Batch::writeRange(const std::unique_ptr<Target>& target,
+                         cfam_address_t address,
+                         const std::vector<cfam_data_t>& data)
+{
+    checkRange(address, data.size());
+
+    size_t first = ops.size();
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        write(target, address + i, data[i]);
+    }
+
+    return first;
+}
+
+bool Batch::contiguous(const Operation& first, const Operation& next)
+{
+    // Cacheable registers go through runOne() so they use the cache
+    return (first.target == next.target) && first.target->hasFD() &&
+           (first.type == next.type) &&
+           (first.type != Type::writeWithMask) &&
+           !first.target->isCacheable(first.address) &&
+           !next.target->isCacheable(next.address) &&
+           (next.offset == first.offset + cfamRegSize);
+}
+
+bool Batch::open(Operation& op)
+{
+    auto access = [&op]() { return op.target->openCFAM(); };
+    auto err = retryAccess(*op.target, toRecordType(op.type), op.address,
+                           access(), access, op.attemptStart);
+    if (err)
+    {
+        fail(op, Access::open, err);
+        return false;
+    }
+
+    return true;
+}
+
+void Batch::fail(Operation& op, Access access, int err)
+{
+    op.result.error = err;
+    op.failedAccess = access;
+    op.target->invalidateCache();
+    failed = true;
+}
+
+void Batch::runOne(Operation& op)
+{
+    auto access = [&op]() {
+        switch (op.type)
+        {
+            case Type::read:
+                op.failedAccess = Access::read;
+                return readRaw(*op.target, op.address, op.offset,
+                               op.result.data);
+
+            case Type::write:
+                op.failedAccess = Access::write;
+                op.result.data = op.data;
+                return writeRaw(*op.target, op.address, op.offset, op.data);
+
+            case Type::writeWithMask:
+                break;
+        }
+
+        bool readFailed = false;
+        auto err = modifyRaw(*op.target, op.address, op.offset, op.data,
+                             op.mask, op.result.data, readFailed);
+        op.failedAccess = readFailed ? Access::read : Access::write;
+        return err;
+    };
+
+    op.attemptStart = std::chrono::steady_clock::now();
+    op.result.error = retryAccess(*op.target, toRecordType(op.type),
+                                  op.address, access(), access,
+                                  op.attemptStart);
+
+    failed = failed || op.result.error;
+}
+
+size_t Batch::runVector(std::vector<Operation>::iterator first, size_t count)
+{
+    std::vector<cfam_data_t> buffer(count);
+    std::vector<struct iovec> iov(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (first->type == Type::write)
+        {
+            buffer[i] = htobe32((first + i)->data);
+        }
+        iov[i].iov_base = &buffer[i];
+        iov[i].iov_len = cfamRegSize;
+    }
+
+    auto fd = first->target->getCFAMFD();
+    auto offset = first->offset;
+
+    ssize_t rc = 0;
+    if (first->type == Type::read)
+    {
+        rc = preadv(fd, iov.data(), count, offset);
+    }
+    else
+    {
+        rc = pwritev(fd, iov.data(), count, offset);
+    }
+
+    // Only whole registers count as done.  Whatever is left over
+    // is retried one register at a time to get its own result.
+    size_t done = (rc > 0) ? (rc / cfamRegSize) : 0;
+    if (done < count)
+    {
+        first->target->invalidateCache();
+    }
+
+    for (size_t i = 0; i < done; i++)
+    {
+        auto& op = *(first + i);
+        op.result.error = 0;
+        op.result.data = (op.type == Type::read) ? be32toh(buffer[i])
+                                                 : op.data;
+    }
+
+    return done;
+}
+
+std::vector<Batch::Operation>::iterator
+    Batch::findWave(std::vector<Operation>::iterator first)
+{
+    std::vector<Target*> targets;
+
+    auto op = first;
+    for (; op != ops.end(); ++op)
+    {
+        if (std::find(targets.begin(), targets.end(), op->target) !=
+            targets.end())
+        {
+            break;
+        }
+
+        // Contiguous registers are better off in one vectored call
+        if ((op + 1 != ops.end()) && contiguous(*op, *(op + 1)))
+        {
+            break;
+        }
+
+        targets.push_back(op->target);
+    }
+
+    return op;
+}
+
+void Batch::runWave(std::vector<Operation>::iterator first,
+                    std::vector<Operation>::iterator last)
+{
+    struct Slot
+    {
+        Operation* op;
+
+        // The big endian data for a transfer
+        cfam_data_t raw = 0;
+
+        // The register value read, or to write
+        cfam_data_t value = 0;
+
+        // The errno of the access
+        int err = 0;
+
+        bool cached = false;
+        bool done = false;
+    };
+
+    // Retries a slot's failed access through its backend, as far as
+    // the policy allows.  An err of -1 does the first access too.
+    auto runDirect = [](Slot& slot, bool write, int err) {
+        auto& op = *slot.op;
+        auto access = [&]() {
+            auto& backend = op.target->getBackend();
+            return write ? backend.write(op.address, op.offset, slot.value)
+                         : backend.read(op.address, op.offset, slot.value);
+        };
+
+        auto type = write ? toRecordType(op.type) : recorder::Type::read;
+        return retryAccess(*op.target, type, op.address,
+                           (err < 0) ? access() : err, access,
+                           op.attemptStart);
+    };
+
+    // Does the accesses of one phase.  Those on backends with a file
+    // descriptor are all put in flight together, and the rest are
+    // done one after the other.  Failed transfers are retried one
+    // at a time.
+    auto runPhase = [&runDirect](std::vector<Slot*>& pending, bool write) {
+        std::vector<engine::Transfer> transfers;
+        std::vector<Slot*> owners;
+
+        for (auto slot : pending)
+        {
+            auto& op = *slot->op;
+
+            if (!op.target->hasFD())
+            {
+                slot->err = runDirect(*slot, write, -1);
+                continue;
+            }
+
+            slot->raw = htobe32(slot->value);
+            transfers.push_back({op.target->getCFAMFD(),
+                                 write,
+                                 op.offset,
+                                 {{&slot->raw, cfamRegSize}}});
+            owners.push_back(slot);
+        }
+
+        engine::run(transfers);
+
+        for (size_t i = 0; i < transfers.size(); i++)
+        {
+            auto& slot = *owners[i];
+
+            slot.err = (transfers[i].result < 0) ? -transfers[i].result : 0;
+            if (slot.err)
+            {
+                slot.err = runDirect(slot, write, slot.err);
+            }
+            else if (!write)
+            {
+                slot.value = be32toh(slot.raw);
+            }
+        }
+    };
+
+    std::vector<Slot> slots;
+    for (auto op = first; op != last; ++op)
+    {
+        if (open(*op))
+        {
+            slots.push_back({&*op});
+        }
+    }
+
+    std::vector<Slot*> pending;
+
+    // First the reads, including the read half of masked writes
+    for (auto& slot : slots)
+    {
+        auto& op = *slot.op;
+        if (op.type == Type::write)
+        {
+            continue;
+        }
+
+        auto cached = op.target->getCachedReg(op.address);
+        if (cached)
+        {
+            slot.value = *cached;
+            slot.cached = true;
+            continue;
+        }
+
+        pending.push_back(&slot);
+    }
+
+    runPhase(pending, false);
+
+    for (auto slot : pending)
+    {
+        auto& op = *slot->op;
+
+        if (slot->err)
+        {
+            fail(op, Access::read, slot->err);
+            slot->done = true;
+            continue;
+        }
+
+        op.target->updateCachedReg(op.address, slot->value);
+    }
+
+    // Then the writes.  If a Target couldn't be opened or read, none
+    // have been written yet, so stopOnError can still write none.
+    pending.clear();
+    bool cancel = failed && (policy == Policy::stopOnError);
+
+    for (auto& slot : slots)
+    {
+        auto& op = *slot.op;
+        if (slot.done)
+        {
+            continue;
+        }
+
+        if (op.type == Type::read)
+        {
+            op.result.data = slot.value;
+            continue;
+        }
+
+        if (cancel)
+        {
+            op.result.error = ECANCELED;
+            op.failedAccess = Access::write;
+            continue;
+        }
+
+        if (op.type == Type::writeWithMask)
+        {
+            cfam_data_t value = (slot.value & ~op.mask) | (op.data & op.mask);
+            if (slot.cached && (value == slot.value))
+            {
+                op.result.data = value;
+                continue;
+            }
+            slot.value = value;
+        }
+        else
+        {
+            slot.value = op.data;
+        }
+
+        pending.push_back(&slot);
+    }
 
-    readData &= ~mask;
-    readData |= (data & mask);
+    runPhase(pending, true);
 
-    writeReg(target, address, readData);
+    for (auto slot : pending)
+    {
+        auto& op = *slot->op;
+
+        if (slot->err)
+        {
+            fail(op, Access::write, slot->err);
+            continue;
+        }
+
+        op.result.data = slot->value;
+        op.target->updateCachedReg(op.address, slot->value);
+    }
+}
+
+void Batch::record(std::vector<Operation>::iterator first,
+                   std::vector<Operation>::iterator last,
+                   std::chrono::steady_clock::time_point start) const
+{
+    for (auto op = first; op != last; ++op)
+    {
+        // Canceled operations never reached the hardware
+        if (op->result.error == ECANCELED)
+        {
+            continue;
+        }
+
+        // Reads record what came back, like the single accesses
+        auto data = (op->type == Type::read) ? op->result.data : op->data;
+        access::record(*op->target, toRecordType(op->type), op->address,
+                       data, op->mask, op->result.error, start,
+                       op->attemptStart);
+    }
+}
+
+void Batch::submit()
+{
+    auto op = ops.begin() + submitted;
+
+    // Every Target is locked for the whole submit, in position
+    // order so two processes can't each hold what the other needs.
+    std::vector<Target*> targets;
+    for (auto it = op; it != ops.end(); ++it)
+    {
+        targets.push_back(it->target);
+    }
+    std::sort(targets.begin(), targets.end(), [](auto a, auto b) {
+        return a->getPos() < b->getPos();
+    });
+    targets.erase(std::unique(targets.begin(), targets.end(),
+                              [](auto a, auto b) {
+                                  return a->getPos() == b->getPos();
+                              }),
+                  targets.end());
+
+    std::vector<arbitration::Lock> locks;
+    for (auto target : targets)
+    {
+        auto held = lock(*target);
+        if (held)
+        {
+            locks.push_back(std::move(*held));
+        }
+    }
+
+    OPENPOWER_PROBE(batch__submit__start, ops.size() - submitted);
+
+    while (op != ops.end())
+    {
+        if (failed && (policy == Policy::stopOnError))
+        {
+            op->result.error = ECANCELED;
+            ++op;
+            continue;
+        }
+
+        // Back to back accesses to different targets don't depend on
+        // each other, so they are all put in flight at the same time.
+        auto start = std::chrono::steady_clock::now();
+        auto waveEnd = findWave(op);
+        std::for_each(op, waveEnd, [start](auto& waveOp) {
+            waveOp.attemptStart = start;
+        });
+        if (waveEnd - op > 1)
+        {
+            runWave(op, waveEnd);
+            record(op, waveEnd, start);
+            op = waveEnd;
+            continue;
+        }
+
+        op->attemptStart = start;
+        if (!open(*op))
+        {
+            record(op, op + 1, start);
+            ++op;
+            continue;
+        }
+
+        size_t count = 1;
+        while ((op + count != ops.end()) && (count < IOV_MAX) &&
+               contiguous(*(op + count - 1), *(op + count)))
+        {
+            count++;
+        }
+
+        size_t done = 0;
+        if (count > 1)
+        {
+            auto vectorStart = std::chrono::steady_clock::now();
+            std::for_each(op, op + count, [vectorStart](auto& vectorOp) {
+                vectorOp.attemptStart = vectorStart;
+            });
+            done = runVector(op, count);
+        }
+
+        if (done == 0)
+        {
+            runOne(*op);
+            done = 1;
+        }
+
+        record(op, op + done, start);
+        op += done;
+    }
+
+    OPENPOWER_PROBE(batch__submit__done, ops.size() - submitted, failed);
+
+    submitted = ops.size();
+}
+
+AccessError Batch::makeError(const Operation& op)
+{
+    return access::makeError(*op.target, op.failedAccess, op.address,
+                             op.offset, op.result.error);
+}
+
+std::expected<cfam_data_t, AccessError> Batch::value(size_t id) const
+{
+    const auto& op = ops.at(id);
+    if (op.result.error)
+    {
+        return std::unexpected(makeError(op));
+    }
+
+    return op.result.data;
+}
+
+void Batch::check() const
+{
+    for (const auto& op : ops)
+    {
+        if ((op.result.error == 0) || (op.result.error == ECANCELED))
+        {
+            continue;
+        }
+
+        throwError(makeError(op));
+    }
 }
 
 } // namespace access
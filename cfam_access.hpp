@@ -1,8 +1,16 @@
 #pragma once
 
+#include "cfam_recorder.hpp"
+#include "cfam_register.hpp"
 #include "targeting.hpp"
 
+#include <chrono>
+#include <expected>
+#include <functional>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace openpower
 {
@@ -45,6 +53,10 @@ cfam_data_t readReg(const std::unique_ptr<openpower::targeting::Target>& target,
  *
  * Only bits that are set in the mask parameter will be modified.
  *
+ * If the register is cacheable on the target and its value is
+ * cached, the read is skipped, and so is a write that wouldn't
+ * change the value.
+ *
  * Throws an exception on error.
  *
  * @param[in] target - The Target to perform the operation on
@@ -55,6 +67,903 @@ cfam_data_t readReg(const std::unique_ptr<openpower::targeting::Target>& target,
 void writeRegWithMask(
     const std::unique_ptr<openpower::targeting::Target>& target,
     cfam_address_t address, cfam_data_t data, cfam_mask_t mask);
+
+/**
+ * @brief Reads a block of CFAM registers with consecutive addresses.
+ *
+ * The registers within a 0x400 address block have contiguous driver
+ * offsets, so each block's part of the range takes a single vectored
+ * read where the backend allows it.
+ *
+ * Throws an exception on error.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] address - The address of the first register
+ * @param[in] count - The number of registers
+ * @return - The register data, in address order
+ */
+std::vector<cfam_data_t>
+    readRange(const std::unique_ptr<openpower::targeting::Target>& target,
+              cfam_address_t address, size_t count);
+
+/**
+ * @brief Writes a block of CFAM registers with consecutive addresses,
+ *        the same way readRange() reads them.
+ *
+ * Throws an exception on error.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] address - The address of the first register
+ * @param[in] data - The data to write, in address order
+ */
+void writeRange(const std::unique_ptr<openpower::targeting::Target>& target,
+                cfam_address_t address, const std::vector<cfam_data_t>& data);
+
+/**
+ * A failed CFAM access, as returned by the try*() APIs
+ */
+struct AccessError
+{
+    /**
+     * The step that failed
+     */
+    enum class Step
+    {
+        open,
+        read,
+        write
+    };
+
+    Step step;
+
+    /**
+     * The errno of the failure
+     */
+    int error;
+
+    /**
+     * The position of the Target
+     */
+    size_t target;
+
+    /**
+     * The CFAM device path, or what the backend uses in its place
+     */
+    std::string path;
+
+    cfam_address_t address;
+
+    /**
+     * The driver offset of the register
+     */
+    cfam_address_t offset;
+};
+
+/**
+ * @brief Throws the exception readReg() and writeReg() would have
+ *        thrown for a failed access.
+ *
+ * @param[in] error - The failure
+ */
+[[noreturn]] void throwError(const AccessError& error);
+
+/**
+ * @brief Reads a CFAM register without throwing on an access failure.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] address - The register address to read
+ * @return - The register data, or the failure
+ */
+std::expected<cfam_data_t, AccessError>
+    tryReadReg(const std::unique_ptr<openpower::targeting::Target>& target,
+               cfam_address_t address);
+
+/**
+ * @brief Writes a CFAM register without throwing on an access failure.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] address - The register address to write to
+ * @param[in] data - The data to write
+ * @return - The data written, or the failure
+ */
+std::expected<cfam_data_t, AccessError>
+    tryWriteReg(const std::unique_ptr<openpower::targeting::Target>& target,
+                cfam_address_t address, cfam_data_t data);
+
+/**
+ * @brief Writes the bits in the mask of a CFAM register without
+ *        throwing on an access failure.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] address - The register address to write to
+ * @param[in] data - The data to write
+ * @param[in] mask - The mask
+ * @return - The full register value written, or the failure
+ */
+std::expected<cfam_data_t, AccessError> tryWriteRegWithMask(
+    const std::unique_ptr<openpower::targeting::Target>& target,
+    cfam_address_t address, cfam_data_t data, cfam_mask_t mask);
+
+/**
+ * @class ErrorSummary
+ *
+ * Collects the failures of best effort accesses so a procedure
+ * logs them once, instead of once per Target or register.
+ */
+class ErrorSummary
+{
+  public:
+    /**
+     * @brief Records the failure, if there is one.
+     *
+     * @param[in] result - The result of an access
+     * @return - true if the access succeeded
+     */
+    template <typename T>
+    bool check(const std::expected<T, AccessError>& result)
+    {
+        if (!result)
+        {
+            errors.push_back(result.error());
+        }
+        return result.has_value();
+    }
+
+    /**
+     * Returns the failures recorded
+     */
+    inline const std::vector<AccessError>& get() const
+    {
+        return errors;
+    }
+
+    /**
+     * @brief Writes one journal entry describing all the failures.
+     *        Does nothing if there weren't any.
+     *
+     * @param[in] procedure - The procedure the accesses were for
+     */
+    void logSummary(const char* procedure) const;
+
+  private:
+    std::vector<AccessError> errors;
+};
+
+/**
+ * The outcome of waitForReg()
+ */
+struct WaitResult
+{
+    /**
+     * If the register reached the expected value by the deadline
+     */
+    bool matched = false;
+
+    /**
+     * The last value read
+     */
+    cfam_data_t data = 0;
+
+    /**
+     * How long the wait took
+     */
+    std::chrono::microseconds elapsed{0};
+
+    /**
+     * The number of times the register was read
+     */
+    size_t polls = 0;
+};
+
+/**
+ * @brief Polls a CFAM register until the bits in the mask have the
+ *        expected value, or the deadline passes.
+ *
+ * The first few polls are back to back, to catch hardware that is
+ * nearly there, and then the sleep between polls doubles up to a
+ * cap.  The register is read one last time at the deadline.
+ * Cached values are never used.
+ *
+ * Throws an exception if a read fails, but not on a timeout.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] address - The register address to poll
+ * @param[in] mask - The bits to check
+ * @param[in] expected - The value the masked bits should have
+ * @param[in] deadline - When to give up
+ * @return - The outcome, including if the value was reached
+ */
+WaitResult
+    waitForReg(const std::unique_ptr<openpower::targeting::Target>& target,
+               cfam_address_t address, cfam_mask_t mask,
+               cfam_data_t expected,
+               std::chrono::steady_clock::time_point deadline);
+
+/**
+ * @brief Polls a CFAM register like waitForReg(), without throwing
+ *        on an access failure.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] address - The register address to poll
+ * @param[in] mask - The bits to check
+ * @param[in] expected - The value the masked bits should have
+ * @param[in] deadline - When to give up
+ * @return - The outcome, or the failure of the read that failed
+ */
+std::expected<WaitResult, AccessError>
+    tryWaitForReg(const std::unique_ptr<openpower::targeting::Target>& target,
+                  cfam_address_t address, cfam_mask_t mask,
+                  cfam_data_t expected,
+                  std::chrono::steady_clock::time_point deadline);
+
+namespace detail
+{
+
+/**
+ * The register accesses behind the register descriptor APIs,
+ * which take the already converted driver offset.
+ */
+void writeReg(const std::unique_ptr<openpower::targeting::Target>& target,
+              cfam_address_t address, cfam_address_t offset,
+              cfam_data_t data);
+
+cfam_data_t readReg(const std::unique_ptr<openpower::targeting::Target>& target,
+                    cfam_address_t address, cfam_address_t offset);
+
+void writeRegWithMask(
+    const std::unique_ptr<openpower::targeting::Target>& target,
+    cfam_address_t address, cfam_address_t offset, cfam_data_t data,
+    cfam_mask_t mask);
+
+std::expected<cfam_data_t, AccessError>
+    tryReadReg(const std::unique_ptr<openpower::targeting::Target>& target,
+               cfam_address_t address, cfam_address_t offset);
+
+std::expected<cfam_data_t, AccessError>
+    tryWriteReg(const std::unique_ptr<openpower::targeting::Target>& target,
+                cfam_address_t address, cfam_address_t offset,
+                cfam_data_t data);
+
+std::expected<cfam_data_t, AccessError> tryWriteRegWithMask(
+    const std::unique_ptr<openpower::targeting::Target>& target,
+    cfam_address_t address, cfam_address_t offset, cfam_data_t data,
+    cfam_mask_t mask);
+
+WaitResult
+    waitForReg(const std::unique_ptr<openpower::targeting::Target>& target,
+               cfam_address_t address, cfam_address_t offset,
+               cfam_mask_t mask, cfam_data_t expected,
+               std::chrono::steady_clock::time_point deadline);
+
+std::expected<WaitResult, AccessError>
+    tryWaitForReg(const std::unique_ptr<openpower::targeting::Target>& target,
+                  cfam_address_t address, cfam_address_t offset,
+                  cfam_mask_t mask, cfam_data_t expected,
+                  std::chrono::steady_clock::time_point deadline);
+
+} // namespace detail
+
+/**
+ * @brief Writes the CFAM register described by a register descriptor.
+ *
+ * The driver offset comes from the descriptor, so it is
+ * resolved at compile time.
+ *
+ * Throws an exception on error.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @param[in] data - The data to write
+ */
+template <WritableRegister Reg>
+inline void
+    writeReg(const std::unique_ptr<openpower::targeting::Target>& target,
+             const Reg&, cfam_data_t data)
+{
+    detail::writeReg(target, Reg::address, Reg::offset, data);
+}
+
+/**
+ * @brief Reads the CFAM register described by a register descriptor.
+ *
+ * Throws an exception on error.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @return - The register data
+ */
+template <ReadableRegister Reg>
+inline cfam_data_t
+    readReg(const std::unique_ptr<openpower::targeting::Target>& target,
+            const Reg&)
+{
+    return detail::readReg(target, Reg::address, Reg::offset);
+}
+
+/**
+ * @brief Writes the CFAM register described by a register descriptor
+ *        using a mask to specify the bits the modify.
+ *
+ * Throws an exception on error.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @param[in] data - The data to write
+ * @param[in] mask - The mask
+ */
+template <WritableRegister Reg>
+    requires ReadableRegister<Reg>
+inline void writeRegWithMask(
+    const std::unique_ptr<openpower::targeting::Target>& target, const Reg&,
+    cfam_data_t data, cfam_mask_t mask)
+{
+    detail::writeRegWithMask(target, Reg::address, Reg::offset, data, mask);
+}
+
+/**
+ * @brief Sets fields of the CFAM register described by a register
+ *        descriptor, leaving the other bits alone.
+ *
+ * Throws an exception on error.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @param[in] fields - The field values, e.g. reg.field(value)
+ */
+template <WritableRegister Reg>
+    requires ReadableRegister<Reg>
+inline void writeRegWithMask(
+    const std::unique_ptr<openpower::targeting::Target>& target,
+    const Reg& reg, const FieldValue& fields)
+{
+    writeRegWithMask(target, reg, fields.data, fields.mask);
+}
+
+/**
+ * @brief Reads the CFAM register described by a register descriptor,
+ *        without throwing on an access failure.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @return - The register data, or the failure
+ */
+template <ReadableRegister Reg>
+inline std::expected<cfam_data_t, AccessError>
+    tryReadReg(const std::unique_ptr<openpower::targeting::Target>& target,
+               const Reg&)
+{
+    return detail::tryReadReg(target, Reg::address, Reg::offset);
+}
+
+/**
+ * @brief Writes the CFAM register described by a register descriptor,
+ *        without throwing on an access failure.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @param[in] data - The data to write
+ * @return - The data written, or the failure
+ */
+template <WritableRegister Reg>
+inline std::expected<cfam_data_t, AccessError>
+    tryWriteReg(const std::unique_ptr<openpower::targeting::Target>& target,
+                const Reg&, cfam_data_t data)
+{
+    return detail::tryWriteReg(target, Reg::address, Reg::offset, data);
+}
+
+/**
+ * @brief Sets fields of the CFAM register described by a register
+ *        descriptor, without throwing on an access failure.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @param[in] fields - The field values, e.g. reg.field(value)
+ * @return - The full register value written, or the failure
+ */
+template <WritableRegister Reg>
+    requires ReadableRegister<Reg>
+inline std::expected<cfam_data_t, AccessError> tryWriteRegWithMask(
+    const std::unique_ptr<openpower::targeting::Target>& target, const Reg&,
+    const FieldValue& fields)
+{
+    return detail::tryWriteRegWithMask(target, Reg::address, Reg::offset,
+                                       fields.data, fields.mask);
+}
+
+/**
+ * @brief Polls the CFAM register described by a register descriptor
+ *        until fields have the expected values, or the deadline passes.
+ *
+ * See the address based waitForReg().
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @param[in] fields - The expected field values, e.g. reg.field(value)
+ * @param[in] deadline - When to give up
+ * @return - The outcome, including if the values were reached
+ */
+template <ReadableRegister Reg>
+inline WaitResult
+    waitForReg(const std::unique_ptr<openpower::targeting::Target>& target,
+               const Reg&, const FieldValue& fields,
+               std::chrono::steady_clock::time_point deadline)
+{
+    return detail::waitForReg(target, Reg::address, Reg::offset,
+                              fields.mask, fields.data, deadline);
+}
+
+/**
+ * @brief Polls the CFAM register described by a register descriptor
+ *        like waitForReg(), without throwing on an access failure.
+ *
+ * @param[in] target - The Target to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @param[in] fields - The expected field values, e.g. reg.field(value)
+ * @param[in] deadline - When to give up
+ * @return - The outcome, or the failure of the read that failed
+ */
+template <ReadableRegister Reg>
+inline std::expected<WaitResult, AccessError>
+    tryWaitForReg(const std::unique_ptr<openpower::targeting::Target>& target,
+                  const Reg&, const FieldValue& fields,
+                  std::chrono::steady_clock::time_point deadline)
+{
+    return detail::tryWaitForReg(target, Reg::address, Reg::offset,
+                                 fields.mask, fields.data, deadline);
+}
+
+/**
+ * @class Batch
+ *
+ * A list of CFAM reads, writes and masked writes, for one or more
+ * Targets, that are submitted together.
+ *
+ * Operations run in the order they were added, except that back to
+ * back accesses to different Targets, like a loop over all the
+ * processors, are put in flight at the same time so they take about
+ * as long as the slowest chip.  Back to back reads or writes of
+ * contiguous registers on the same Target are sent as a single
+ * preadv/pwritev call.  Every operation gets its own result, including
+ * a failure to open the Target's device, so one failure does not lose
+ * the results of the others.
+ */
+class Batch
+{
+  public:
+    /**
+     * What to do with the remaining operations after one fails
+     */
+    enum class Policy
+    {
+        bestEffort, // Run all of them anyway
+        stopOnError // Cancel them with ECANCELED
+    };
+
+    /**
+     * The outcome of a single operation
+     */
+    struct Result
+    {
+        /**
+         * 0 on success, otherwise the errno of the failure
+         */
+        int error = 0;
+
+        /**
+         * The data read, or the full register value written
+         */
+        cfam_data_t data = 0;
+    };
+
+    /**
+     * Constructor
+     *
+     * @param[in] policy - What to do after an operation fails
+     */
+    explicit Batch(Policy policy = Policy::bestEffort) : policy(policy) {}
+
+    ~Batch() = default;
+    Batch(const Batch&) = delete;
+    Batch& operator=(const Batch&) = delete;
+    Batch(Batch&&) = default;
+    Batch& operator=(Batch&&) = default;
+
+    /**
+     * @brief Queues a register read
+     *
+     * @param[in] target - The Target to perform the operation on
+     * @param[in] address - The register address to read
+     * @return - The ID of the operation, for use with result()
+     */
+    size_t read(const std::unique_ptr<openpower::targeting::Target>& target,
+                cfam_address_t address);
+
+    /**
+     * @brief Queues a register write
+     *
+     * @param[in] target - The Target to perform the operation on
+     * @param[in] address - The register address to write to
+     * @param[in] data - The data to write
+     * @return - The ID of the operation, for use with result()
+     */
+    size_t write(const std::unique_ptr<openpower::targeting::Target>& target,
+                 cfam_address_t address, cfam_data_t data);
+
+    /**
+     * @brief Queues a register write that only modifies the bits
+     *        set in the mask.
+     *
+     * @param[in] target - The Target to perform the operation on
+     * @param[in] address - The register address to write to
+     * @param[in] data - The data to write
+     * @param[in] mask - The mask
+     * @return - The ID of the operation, for use with result()
+     */
+    size_t writeWithMask(
+        const std::unique_ptr<openpower::targeting::Target>& target,
+        cfam_address_t address, cfam_data_t data, cfam_mask_t mask);
+
+    /**
+     * @brief Queues reads of a block of registers with consecutive
+     *        addresses.  See readRange().
+     *
+     * @param[in] target - The Target to perform the operation on
+     * @param[in] address - The address of the first register
+     * @param[in] count - The number of registers
+     * @return - The ID of the first read.  The rest follow it.
+     */
+    size_t readRange(
+        const std::unique_ptr<openpower::targeting::Target>& target,
+        cfam_address_t address, size_t count);
+
+    /**
+     * @brief Queues writes of a block of registers with consecutive
+     *        addresses.  See writeRange().
+     *
+     * @param[in] target - The Target to perform the operation on
+     * @param[in] address - The address of the first register
+     * @param[in] data - The data to write, in address order
+     * @return - The ID of the first write.  The rest follow it.
+     */
+    size_t writeRange(
+        const std::unique_ptr<openpower::targeting::Target>& target,
+        cfam_address_t address, const std::vector<cfam_data_t>& data);
+
+    /**
+     * @brief Queues a read of the register described by a descriptor
+     *
+     * @param[in] target - The Target to perform the operation on
+     * @param[in] reg - The register descriptor
+     * @return - The ID of the operation, for use with result()
+     */
+    template <ReadableRegister Reg>
+    size_t read(const std::unique_ptr<openpower::targeting::Target>& target,
+                const Reg&)
+    {
+        return queue(target, Reg::address, Reg::offset, 0, 0, Type::read);
+    }
+
+    /**
+     * @brief Queues a write of the register described by a descriptor
+     *
+     * @param[in] target - The Target to perform the operation on
+     * @param[in] reg - The register descriptor
+     * @param[in] data - The data to write
+     * @return - The ID of the operation, for use with result()
+     */
+    template <WritableRegister Reg>
+    size_t write(const std::unique_ptr<openpower::targeting::Target>& target,
+                 const Reg&, cfam_data_t data)
+    {
+        return queue(target, Reg::address, Reg::offset, data, 0, Type::write);
+    }
+
+    /**
+     * @brief Queues a masked write of the register described by
+     *        a descriptor.
+     *
+     * @param[in] target - The Target to perform the operation on
+     * @param[in] reg - The register descriptor
+     * @param[in] fields - The field values, e.g. reg.field(value)
+     * @return - The ID of the operation, for use with result()
+     */
+    template <WritableRegister Reg>
+        requires ReadableRegister<Reg>
+    size_t writeWithMask(
+        const std::unique_ptr<openpower::targeting::Target>& target,
+        const Reg&, const FieldValue& fields)
+    {
+        return queue(target, Reg::address, Reg::offset, fields.data,
+                     fields.mask, Type::writeWithMask);
+    }
+
+    /**
+     * @brief Runs every operation queued since the last submit.
+     *
+     * Does not throw on access failures; see result() and check().
+     */
+    void submit();
+
+    /**
+     * Returns the result of an operation
+     *
+     * @param[in] id - The ID returned when the operation was queued
+     */
+    inline const Result& result(size_t id) const
+    {
+        return ops.at(id).result;
+    }
+
+    /**
+     * @brief Returns the data of an operation, or its failure
+     *        if it failed or was canceled.
+     *
+     * @param[in] id - The ID returned when the operation was queued
+     */
+    std::expected<cfam_data_t, AccessError> value(size_t id) const;
+
+    /**
+     * Returns true if any submitted operation failed
+     */
+    inline bool hasFailure() const
+    {
+        return failed;
+    }
+
+    /**
+     * @brief Throws the error of the first failed operation, using the
+     *        same exceptions as readReg() and writeReg().
+     */
+    void check() const;
+
+  private:
+    /**
+     * The kind of access
+     */
+    enum class Type
+    {
+        read,
+        write,
+        writeWithMask
+    };
+
+    /**
+     * The step of an operation that failed
+     */
+    using Access = AccessError::Step;
+
+    /**
+     * A queued operation
+     */
+    struct Operation
+    {
+        openpower::targeting::Target* target;
+        cfam_address_t address;
+        cfam_address_t offset;
+        cfam_data_t data;
+        cfam_mask_t mask;
+        Type type;
+
+        /**
+         * The step that failed
+         */
+        Access failedAccess;
+
+        Result result;
+
+        /**
+         * When the last attempt at the operation started
+         */
+        std::chrono::steady_clock::time_point attemptStart;
+    };
+
+    /**
+     * Adds an operation to the list
+     *
+     * @return - The ID of the operation
+     */
+    size_t queue(const std::unique_ptr<openpower::targeting::Target>& target,
+                 cfam_address_t address, cfam_address_t offset,
+                 cfam_data_t data, cfam_mask_t mask, Type type);
+
+    /**
+     * Returns true if next can share a vectored call with first
+     */
+    static bool contiguous(const Operation& first, const Operation& next);
+
+    /**
+     * Opens the operation's Target, recording the failure if it can't
+     *
+     * @return - true on success
+     */
+    bool open(Operation& op);
+
+    /**
+     * Records a failed operation
+     */
+    void fail(Operation& op, Access access, int err);
+
+    /**
+     * Returns the failure of an operation that didn't succeed
+     */
+    static AccessError makeError(const Operation& op);
+
+    /**
+     * Runs a single operation
+     */
+    void runOne(Operation& op);
+
+    /**
+     * Runs count contiguous reads or writes with one preadv/pwritev.
+     *
+     * @return - The number of operations that completed
+     */
+    size_t runVector(std::vector<Operation>::iterator first, size_t count);
+
+    /**
+     * Finds the end of the run of single register accesses, each to
+     * a different Target, that starts at first.
+     */
+    std::vector<Operation>::iterator
+        findWave(std::vector<Operation>::iterator first);
+
+    /**
+     * Adds the operations run since start to their Targets'
+     * statistics, and to the recording if recording is on.
+     */
+    void record(std::vector<Operation>::iterator first,
+                std::vector<Operation>::iterator last,
+                std::chrono::steady_clock::time_point start) const;
+
+    /**
+     * Returns the recorder's name for an access type
+     */
+    static recorder::Type toRecordType(Type type);
+
+    /**
+     * Runs a run found by findWave() through the CFAM engine so all the
+     * accesses are in flight at the same time.
+     */
+    void runWave(std::vector<Operation>::iterator first,
+                 std::vector<Operation>::iterator last);
+
+    /**
+     * What to do after an operation fails
+     */
+    Policy policy;
+
+    /**
+     * The queued operations
+     */
+    std::vector<Operation> ops;
+
+    /**
+     * The number of operations already submitted
+     */
+    size_t submitted = 0;
+
+    /**
+     * If any submitted operation has failed
+     */
+    bool failed = false;
+};
+
+/**
+ * The outcome of a broadcast on each Target, by Target position
+ */
+using BroadcastResult =
+    std::map<size_t, std::expected<cfam_data_t, AccessError>>;
+
+namespace detail
+{
+
+/**
+ * @brief Queues one operation per Target in a single Batch and
+ *        submits it, so the accesses are all in flight together.
+ *
+ * @param[in] targets - The Targets to perform the operation on
+ * @param[in] policy - What to do if a Target fails
+ * @param[in] queue - Queues the operation for a Target
+ * @return - The outcome on each Target
+ */
+BroadcastResult broadcast(
+    openpower::targeting::Targeting& targets, Batch::Policy policy,
+    const std::function<size_t(
+        Batch&, const std::unique_ptr<openpower::targeting::Target>&)>&
+        queue);
+
+} // namespace detail
+
+/**
+ * @brief Writes the same value to a CFAM register on every Target at
+ *        the same time, so it takes about as long as one write.
+ *
+ * With Policy::stopOnError, nothing is written unless every Target
+ * could be opened, and the first failure is thrown after the others
+ * are done.  With Policy::bestEffort, failures are only returned.
+ *
+ * @param[in] targets - The Targets to perform the operation on
+ * @param[in] address - The register address to write to
+ * @param[in] data - The data to write
+ * @param[in] policy - What to do if a Target fails
+ * @return - The outcome on each Target
+ */
+BroadcastResult broadcastWrite(
+    openpower::targeting::Targeting& targets, cfam_address_t address,
+    cfam_data_t data, Batch::Policy policy = Batch::Policy::stopOnError);
+
+/**
+ * @brief Writes the bits in the mask of a CFAM register on every Target
+ *        at the same time.
+ *
+ * The reads of the register are all done before any write, so with
+ * Policy::stopOnError nothing is written unless every Target could
+ * be read.  See broadcastWrite().
+ *
+ * @param[in] targets - The Targets to perform the operation on
+ * @param[in] address - The register address to write to
+ * @param[in] data - The data to write
+ * @param[in] mask - The mask
+ * @param[in] policy - What to do if a Target fails
+ * @return - The outcome on each Target
+ */
+BroadcastResult broadcastWriteWithMask(
+    openpower::targeting::Targeting& targets, cfam_address_t address,
+    cfam_data_t data, cfam_mask_t mask,
+    Batch::Policy policy = Batch::Policy::stopOnError);
+
+/**
+ * @brief Writes the CFAM register described by a register descriptor
+ *        on every Target at the same time.  See broadcastWrite().
+ *
+ * @param[in] targets - The Targets to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @param[in] data - The data to write
+ * @param[in] policy - What to do if a Target fails
+ * @return - The outcome on each Target
+ */
+template <WritableRegister Reg>
+inline BroadcastResult
+    broadcastWrite(openpower::targeting::Targeting& targets, const Reg& reg,
+                   cfam_data_t data,
+                   Batch::Policy policy = Batch::Policy::stopOnError)
+{
+    return detail::broadcast(
+        targets, policy,
+        [&reg, data](Batch& batch,
+                     const std::unique_ptr<openpower::targeting::Target>& t) {
+            return batch.write(t, reg, data);
+        });
+}
+
+/**
+ * @brief Sets fields of the CFAM register described by a register
+ *        descriptor on every Target at the same time.
+ *        See broadcastWriteWithMask().
+ *
+ * @param[in] targets - The Targets to perform the operation on
+ * @param[in] reg - The register descriptor
+ * @param[in] fields - The field values, e.g. reg.field(value)
+ * @param[in] policy - What to do if a Target fails
+ * @return - The outcome on each Target
+ */
+template <WritableRegister Reg>
+    requires ReadableRegister<Reg>
+inline BroadcastResult broadcastWriteWithMask(
+    openpower::targeting::Targeting& targets, const Reg& reg,
+    const FieldValue& fields,
+    Batch::Policy policy = Batch::Policy::stopOnError)
+{
+    return detail::broadcast(
+        targets, policy,
+        [&reg, &fields](
+            Batch& batch,
+            const std::unique_ptr<openpower::targeting::Target>& t) {
+            return batch.writeWithMask(t, reg, fields);
+        });
+}
+
 } // namespace access
 } // namespace cfam
 } // namespace openpower
@@ -0,0 +1,315 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cfam_arbitration.hpp"
+
+#include "tracing.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace arbitration
+{
+
+using namespace phosphor::logging;
+using namespace std::chrono;
+
+/**
+ * Each chip has a region of lockPath with the lock itself and then
+ * the markers of the critical and normal waiters.
+ */
+constexpr off_t regionSize = 4;
+constexpr off_t ownerByte = 0;
+constexpr off_t criticalByte = 1;
+constexpr off_t normalByte = 2;
+
+/**
+ * The wait for the lock that is worth a journal entry
+ */
+constexpr auto longWait = milliseconds(100);
+
+/**
+ * Returns the process's descriptor for lockPath, or -1 if it
+ * can't be used.
+ */
+static int getLockFD()
+{
+    static int fd = []() {
+        std::error_code ec;
+        std::filesystem::create_directories(
+            std::filesystem::path{lockPath}.parent_path(), ec);
+
+        int newFD = open(lockPath, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (newFD < 0)
+        {
+            // Arbitration must not stop a procedure
+            log<level::ERR>("Failed to open the CFAM lock file",
+                            entry("PATH=%s", lockPath),
+                            entry("ERRNO=%d", errno));
+        }
+        return newFD;
+    }();
+
+    return fd;
+}
+
+/**
+ * Returns the mutex that serializes this process's threads on a chip
+ */
+static std::mutex& getThreadMutex(size_t position)
+{
+    static std::map<size_t, std::mutex> mutexes;
+    static std::mutex mapMutex;
+
+    std::lock_guard<std::mutex> lock(mapMutex);
+    return mutexes[position];
+}
+
+/**
+ * How many Locks this thread has on each chip
+ */
+static thread_local std::map<size_t, unsigned> threadDepth;
+
+/**
+ * Locks, unlocks or tests bytes of lockPath
+ *
+ * @return 0 on success, else the errno
+ */
+static int setLock(int fd, int cmd, short type, off_t start, off_t length)
+{
+    struct flock lock
+    {};
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = start;
+    lock.l_len = length;
+
+    int rc = 0;
+    do
+    {
+        rc = fcntl(fd, cmd, &lock);
+    } while ((rc < 0) && (errno == EINTR));
+
+    return (rc < 0) ? errno : 0;
+}
+
+/**
+ * Returns true if another process holds any lock on the bytes
+ */
+static bool isLocked(int fd, off_t start, off_t length)
+{
+    struct flock lock
+    {};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = start;
+    lock.l_len = length;
+
+    if (fcntl(fd, F_OFD_GETLK, &lock) < 0)
+    {
+        return false;
+    }
+
+    return lock.l_type != F_UNLCK;
+}
+
+/**
+ * Returns the process's priority class for changing
+ */
+static std::optional<Priority>& processPriority()
+{
+    static std::optional<Priority> priority = []() {
+        std::optional<Priority> envPriority;
+
+        auto env = getenv(priorityEnv);
+        if ((env == nullptr) || !strcmp(env, "off"))
+        {
+            return envPriority;
+        }
+
+        envPriority = Priority::normal;
+        if (!strcmp(env, "critical"))
+        {
+            envPriority = Priority::critical;
+        }
+        else if (!strcmp(env, "background"))
+        {
+            envPriority = Priority::background;
+        }
+
+        return envPriority;
+    }();
+
+    return priority;
+}
+
+std::optional<Priority> getPriority()
+{
+    return processPriority();
+}
+
+void setPriority(std::optional<Priority> priority)
+{
+    processPriority() = priority;
+}
+
+Lock::Lock(size_t position, Priority priority) : pos(position)
+{
+    // The mutex isn't recursive, and the outer Lock has the chip
+    if (threadDepth[position]++)
+    {
+        return;
+    }
+
+    threadLock = std::unique_lock<std::mutex>(getThreadMutex(position));
+
+    auto start = steady_clock::now();
+    int fd = getLockFD();
+    off_t region = position * regionSize;
+
+    if (fd < 0)
+    {
+        return;
+    }
+
+    int err = 0;
+
+    if (priority == Priority::critical)
+    {
+        // Nobody is using the chip, which is the usual case
+        err = setLock(fd, F_OFD_SETLK, F_WRLCK, region + ownerByte, 1);
+        if ((err == EAGAIN) || (err == EACCES))
+        {
+            // Announce the wait so the others step aside, and
+            // then queue for the chip.
+            setLock(fd, F_OFD_SETLK, F_RDLCK, region + criticalByte, 1);
+            err = setLock(fd, F_OFD_SETLKW, F_WRLCK, region + ownerByte, 1);
+            setLock(fd, F_OFD_SETLK, F_UNLCK, region + criticalByte, 1);
+        }
+    }
+    else
+    {
+        // Waiters of a higher class have the markers before ours,
+        // and go first even if the chip is free.
+        auto higher = region + criticalByte;
+        auto higherLength = (priority == Priority::normal) ? 1 : 2;
+        bool announced = false;
+        auto sleep = microseconds(50);
+
+        while (true)
+        {
+            err = isLocked(fd, higher, higherLength)
+                      ? EAGAIN
+                      : setLock(fd, F_OFD_SETLK, F_WRLCK, region + ownerByte,
+                                1);
+            if ((err != EAGAIN) && (err != EACCES))
+            {
+                break;
+            }
+
+            if ((priority == Priority::normal) && !announced)
+            {
+                setLock(fd, F_OFD_SETLK, F_RDLCK, region + normalByte, 1);
+                announced = true;
+            }
+
+            std::this_thread::sleep_for(sleep);
+            sleep = std::min<microseconds>(sleep * 2, milliseconds(2));
+        }
+
+        if (announced)
+        {
+            setLock(fd, F_OFD_SETLK, F_UNLCK, region + normalByte, 1);
+        }
+    }
+
+    if (err)
+    {
+        // Such as a kernel without OFD locks
+        log<level::ERR>("Failed to lock a CFAM", entry("POSITION=%zu", pos),
+                        entry("ERRNO=%d", err));
+    }
+
+    held = (err == 0);
+    wait = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+    OPENPOWER_PROBE(cfam__lock__done, pos, static_cast<int>(priority),
+                    wait.count());
+
+    if (wait >= longWait)
+    {
+        log<level::INFO>(
+            "Waited for another process to finish with a CFAM",
+            entry("POSITION=%zu", pos),
+            entry("PRIORITY=%d", static_cast<int>(priority)),
+            entry("WAIT_US=%lld",
+                  static_cast<long long>(
+                      duration_cast<microseconds>(wait).count())));
+    }
+}
+
+Lock::Lock(Lock&& other) noexcept :
+    pos(other.pos), threadLock(std::move(other.threadLock)), held(other.held),
+    counted(other.counted), wait(other.wait)
+{
+    other.held = false;
+    other.counted = false;
+}
+
+Lock::~Lock()
+{
+    if (held)
+    {
+        setLock(getLockFD(), F_OFD_SETLK, F_UNLCK,
+                pos * regionSize + ownerByte, 1);
+    }
+
+    if (counted)
+    {
+        threadDepth[pos]--;
+    }
+}
+
+std::optional<Lock> acquire(size_t position)
+{
+    std::optional<Lock> lock;
+
+    auto priority = getPriority();
+    if (priority)
+    {
+        lock.emplace(position, *priority);
+    }
+
+    return lock;
+}
+
+} // namespace arbitration
+} // namespace cfam
+} // namespace openpower
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace arbitration
+{
+
+/**
+ * The priority class of the process's CFAM accesses: "critical",
+ * "normal", "background", or "off" to not take part in arbitration.
+ * Processes that don't set it don't take part either, so they don't
+ * pay for the locking.
+ */
+constexpr auto priorityEnv = "OPENPOWER_CFAM_PRIORITY";
+
+/**
+ * The file the processes lock regions of, one region per chip
+ */
+constexpr auto lockPath = "/run/openpower-proc-control/cfam.lock";
+
+/**
+ * How soon another process gets a chip that is in use
+ */
+enum class Priority : uint8_t
+{
+    background, // Waits for any normal or critical waiter
+    normal,     // Waits for any critical waiter
+    critical    // Waits only for the process using the chip
+};
+
+/**
+ * Returns the process's priority class from priorityEnv, or nothing
+ * if it is off or not set, unless setPriority() changed it.
+ */
+std::optional<Priority> getPriority();
+
+/**
+ * @brief Changes the process's priority class.
+ *
+ * It isn't synchronized with accesses, so it is for before they start.
+ *
+ * @param[in] priority - The new class, or nothing to not take part
+ */
+void setPriority(std::optional<Priority> priority);
+
+/**
+ * @class Lock
+ *
+ * Exclusive use of a chip's FSI link among the processes that take
+ * part in arbitration, and the threads of this one.
+ *
+ * The lock is an OFD (open file description) lock on a byte of
+ * lockPath, so the kernel drops it if the holder dies.  Waiting
+ * critical and normal processes hold a shared lock on a marker
+ * byte, and processes of a lower class step aside while they see
+ * one, so a power off doesn't queue behind a background logger.
+ *
+ * A thread that already has the chip locked can lock it again, such
+ * as a waitForReg() in the middle of a locked sequence.  Only the
+ * outermost Lock does the locking.
+ */
+class Lock
+{
+  public:
+    /**
+     * @brief Waits for the lock on a chip.
+     *
+     * @param[in] position - The position of the chip
+     * @param[in] priority - The priority class to wait with
+     */
+    Lock(size_t position, Priority priority);
+
+    ~Lock();
+    Lock(const Lock&) = delete;
+    Lock& operator=(const Lock&) = delete;
+    Lock(Lock&& other) noexcept;
+    Lock& operator=(Lock&&) = delete;
+
+    /**
+     * Returns how long it took to get the lock
+     */
+    inline std::chrono::nanoseconds getWait() const
+    {
+        return wait;
+    }
+
+  private:
+    /**
+     * The position of the chip
+     */
+    size_t pos;
+
+    /**
+     * Serializes the threads of this process, which share an
+     * open file description and so wouldn't block each other.
+     */
+    std::unique_lock<std::mutex> threadLock;
+
+    /**
+     * If the byte in lockPath is held
+     */
+    bool held = false;
+
+    /**
+     * If this Lock counts in the thread's depth on the chip, which
+     * a moved from one doesn't
+     */
+    bool counted = true;
+
+    /**
+     * How long it took to get the lock
+     */
+    std::chrono::nanoseconds wait{0};
+};
+
+/**
+ * @brief Locks a chip with the process's priority class.
+ *
+ * @param[in] position - The position of the chip
+ * @return - The lock, or nothing if arbitration is off
+ */
+std::optional<Lock> acquire(size_t position);
+
+} // namespace arbitration
+} // namespace cfam
+} // namespace openpower
@@ -0,0 +1,89 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cfam_backend.hpp"
+
+#include <endian.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace backend
+{
+
+int SysfsBackend::open()
+{
+    int newFD = ::open(path.c_str(), O_RDWR | O_SYNC);
+    if (newFD < 0)
+    {
+        return errno;
+    }
+
+    fd = std::make_unique<openpower::util::FileDescriptor>(newFD);
+    return 0;
+}
+
+int SysfsBackend::read(uint16_t /*address*/, uint16_t offset, uint32_t& data)
+{
+    uint32_t raw = 0;
+
+    // A positional read leaves the shared file offset alone, so
+    // several threads can use the same Target concurrently.
+    if (pread(getFD(), &raw, sizeof(raw), offset) < 0)
+    {
+        return errno;
+    }
+
+    data = be32toh(raw);
+    return 0;
+}
+
+int SysfsBackend::write(uint16_t /*address*/, uint16_t offset, uint32_t data)
+{
+    uint32_t raw = htobe32(data);
+
+    if (pwrite(getFD(), &raw, sizeof(raw), offset) < 0)
+    {
+        return errno;
+    }
+
+    return 0;
+}
+
+int MemoryBackend::read(uint16_t address, uint16_t /*offset*/, uint32_t& data)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto reg = registers.find(address);
+    data = (reg != registers.end()) ? reg->second : 0;
+    return 0;
+}
+
+int MemoryBackend::write(uint16_t address, uint16_t /*offset*/, uint32_t data)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    registers[address] = data;
+    return 0;
+}
+
+} // namespace backend
+} // namespace cfam
+} // namespace openpower
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "filedescriptor.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace backend
+{
+
+/**
+ * @class Backend
+ *
+ * The interface a Target uses to reach its CFAM.
+ *
+ * Register accesses are given both the address from the spec and the
+ * offset the FSI device driver uses, so each backend can use the one
+ * it needs.  Data is in host byte order.
+ */
+class Backend
+{
+  public:
+    Backend() = default;
+    virtual ~Backend() = default;
+    Backend(const Backend&) = delete;
+    Backend& operator=(const Backend&) = delete;
+    Backend(Backend&&) = delete;
+    Backend& operator=(Backend&&) = delete;
+
+    /**
+     * @brief Gets the backend ready for register accesses, such
+     *        as by opening a device.  Only called once.
+     *
+     * @return 0 on success, else an errno
+     */
+    virtual int open() = 0;
+
+    /**
+     * @brief Returns true if the backend's accesses are positional
+     *        reads and writes of big endian words on getFD(), which
+     *        lets them be vectored or done through the CFAM engine.
+     */
+    virtual bool hasFD() const
+    {
+        return false;
+    }
+
+    /**
+     * @brief Returns the file descriptor behind hasFD(), or -1
+     */
+    virtual int getFD() const
+    {
+        return -1;
+    }
+
+    /**
+     * @brief Reads a register
+     *
+     * @param[in] address - The register address from the spec
+     * @param[in] offset - The device driver offset of the register
+     * @param[out] data - The register data
+     *
+     * @return 0 on success, else an errno
+     */
+    virtual int read(uint16_t address, uint16_t offset, uint32_t& data) = 0;
+
+    /**
+     * @brief Writes a register
+     *
+     * @param[in] address - The register address from the spec
+     * @param[in] offset - The device driver offset of the register
+     * @param[in] data - The data to write
+     *
+     * @return 0 on success, else an errno
+     */
+    virtual int write(uint16_t address, uint16_t offset, uint32_t data) = 0;
+
+    /**
+     * @brief Returns the path of the device, for error logs
+     */
+    virtual const std::string& getPath() const = 0;
+};
+
+/**
+ * @class SysfsBackend
+ *
+ * Accesses the CFAM through an FSI 'raw' sysfs file, or anything
+ * else that takes positional reads and writes at driver offsets,
+ * like the /dev/cfamN character devices.
+ */
+class SysfsBackend : public Backend
+{
+  public:
+    /**
+     * Constructor
+     *
+     * @param[in] path - The path of the raw file
+     */
+    explicit SysfsBackend(const std::string& path) : path(path) {}
+
+    int open() override;
+
+    bool hasFD() const override
+    {
+        return true;
+    }
+
+    int getFD() const override
+    {
+        return fd ? fd->get() : -1;
+    }
+
+    int read(uint16_t address, uint16_t offset, uint32_t& data) override;
+
+    int write(uint16_t address, uint16_t offset, uint32_t data) override;
+
+    const std::string& getPath() const override
+    {
+        return path;
+    }
+
+  private:
+    /**
+     * The path of the raw file
+     */
+    const std::string path;
+
+    /**
+     * The open raw file
+     */
+    std::unique_ptr<openpower::util::FileDescriptor> fd;
+};
+
+/**
+ * @class MemoryBackend
+ *
+ * An in-memory register file that stands in for a chip on hosts
+ * without FSI hardware.  Registers that were never written read
+ * back as 0.
+ */
+class MemoryBackend : public Backend
+{
+  public:
+    /**
+     * Constructor
+     *
+     * @param[in] name - The name to use in place of a device path
+     */
+    explicit MemoryBackend(const std::string& name) : name(name) {}
+
+    int open() override
+    {
+        return 0;
+    }
+
+    int read(uint16_t address, uint16_t offset, uint32_t& data) override;
+
+    int write(uint16_t address, uint16_t offset, uint32_t data) override;
+
+    const std::string& getPath() const override
+    {
+        return name;
+    }
+
+  private:
+    /**
+     * The name to use in place of a device path
+     */
+    const std::string name;
+
+    /**
+     * The register contents, by address
+     */
+    std::map<uint16_t, uint32_t> registers;
+
+    /**
+     * Serializes access to the registers
+     */
+    std::mutex mutex;
+};
+
+} // namespace backend
+} // namespace cfam
+} // namespace openpower
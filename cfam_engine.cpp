@@ -0,0 +1,280 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+
+#include "cfam_engine.hpp"
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+#include <unistd.h>
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <mutex>
+#include <thread>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace engine
+{
+
+using namespace phosphor::logging;
+
+/**
+ * Does a transfer with a blocking call
+ */
+static void runBlocking(Transfer& transfer)
+{
+    ssize_t rc = 0;
+
+    if (transfer.write)
+    {
+        rc = pwritev(transfer.fd, transfer.iov.data(), transfer.iov.size(),
+                     transfer.offset);
+    }
+    else
+    {
+        rc = preadv(transfer.fd, transfer.iov.data(), transfer.iov.size(),
+                    transfer.offset);
+    }
+
+    transfer.result = (rc < 0) ? -errno : rc;
+}
+
+#ifdef HAVE_LIBURING
+
+/**
+ * The number of transfers that can be in flight at once
+ */
+constexpr unsigned ringEntries = 64;
+
+/**
+ * How many times in a row a submit that is out of resources
+ * is tried again before giving up on the ring
+ */
+constexpr unsigned submitRetries = 8;
+
+/**
+ * The process wide io_uring instance
+ */
+class Ring
+{
+  public:
+    Ring()
+    {
+        auto rc = io_uring_queue_init(ringEntries, &ring, 0);
+        if (rc < 0)
+        {
+            // Likely an old kernel or io_uring being disabled
+            log<level::INFO>("io_uring unavailable, using blocking CFAM "
+                             "access",
+                             entry("ERRNO=%d", -rc));
+            return;
+        }
+
+        initialized = true;
+        ok = true;
+    }
+
+    ~Ring()
+    {
+        if (initialized)
+        {
+            io_uring_queue_exit(&ring);
+        }
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+    Ring(Ring&&) = delete;
+    Ring& operator=(Ring&&) = delete;
+
+    /**
+     * Returns true if the ring was set up
+     */
+    inline bool isOK() const
+    {
+        return ok;
+    }
+
+    /**
+     * Submits up to ringEntries transfers and waits for them.
+     *
+     * @return The number of transfers, from the start, that were
+     *         submitted.  The rest still need to be done.
+     */
+    unsigned run(Transfer* transfers, unsigned count);
+
+  private:
+    struct io_uring ring;
+
+    /**
+     * If io_uring_queue_init() succeeded
+     */
+    bool initialized = false;
+
+    /**
+     * If the ring can be used
+     */
+    std::atomic<bool> ok = false;
+
+    /**
+     * The ring isn't thread safe, so one batch of
+     * transfers is in flight at a time.
+     */
+    std::mutex mutex;
+};
+
+unsigned Ring::run(Transfer* transfers, unsigned count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        auto& transfer = transfers[i];
+        auto sqe = io_uring_get_sqe(&ring);
+
+        if (transfer.write)
+        {
+            io_uring_prep_writev(sqe, transfer.fd, transfer.iov.data(),
+                                 transfer.iov.size(), transfer.offset);
+        }
+        else
+        {
+            io_uring_prep_readv(sqe, transfer.fd, transfer.iov.data(),
+                                transfer.iov.size(), transfer.offset);
+        }
+
+        io_uring_sqe_set_data(sqe, &transfer);
+
+        // Until its completion is reaped
+        transfer.result = -EINPROGRESS;
+    }
+
+    unsigned submitted = 0;
+    unsigned busy = 0;
+    while (submitted < count)
+    {
+        auto rc = io_uring_submit(&ring);
+        if (rc > 0)
+        {
+            submitted += rc;
+            busy = 0;
+            continue;
+        }
+
+        // Out of kernel resources for now, so try again a few times
+        if (((rc == 0) || (rc == -EAGAIN) || (rc == -EBUSY) ||
+             (rc == -EINTR)) &&
+            (++busy <= submitRetries))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // What's left is stuck in the submission queue, so
+        // stop using the ring and fall back to blocking calls.
+        log<level::ERR>("Failed submitting CFAM transfers to io_uring",
+                        entry("ERRNO=%d", -rc));
+        ok = false;
+        break;
+    }
+
+    for (unsigned reaped = 0; reaped < submitted;)
+    {
+        struct io_uring_cqe* cqe = nullptr;
+
+        auto rc = io_uring_wait_cqe(&ring, &cqe);
+        if (rc == -EINTR)
+        {
+            continue;
+        }
+
+        if (rc < 0)
+        {
+            // The completions can't be reaped, so fail the transfers
+            // still in flight rather than running them again, and
+            // stop using the ring.
+            log<level::ERR>("Failed waiting for CFAM transfers on io_uring",
+                            entry("ERRNO=%d", -rc));
+            ok = false;
+
+            for (unsigned j = 0; j < submitted; j++)
+            {
+                if (transfers[j].result == -EINPROGRESS)
+                {
+                    transfers[j].result = rc;
+                }
+            }
+            break;
+        }
+
+        auto transfer = static_cast<Transfer*>(io_uring_cqe_get_data(cqe));
+        transfer->result = cqe->res;
+        io_uring_cqe_seen(&ring, cqe);
+        reaped++;
+    }
+
+    return submitted;
+}
+
+static Ring& getRing()
+{
+    static Ring ring;
+    return ring;
+}
+
+#endif
+
+void run(std::vector<Transfer>& transfers)
+{
+    size_t next = 0;
+
+#ifdef HAVE_LIBURING
+    auto& ring = getRing();
+
+    // A single transfer gains nothing from going through the ring
+    while (ring.isOK() && (transfers.size() > 1) && (next < transfers.size()))
+    {
+        auto count = std::min<size_t>(transfers.size() - next, ringEntries);
+        next += ring.run(&transfers[next], count);
+    }
+#endif
+
+    for (; next < transfers.size(); next++)
+    {
+        runBlocking(transfers[next]);
+    }
+}
+
+bool isAsync()
+{
+#ifdef HAVE_LIBURING
+    return getRing().isOK();
+#else
+    return false;
+#endif
+}
+
+} // namespace engine
+} // namespace cfam
+} // namespace openpower
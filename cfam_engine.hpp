@@ -0,0 +1,67 @@
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <vector>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace engine
+{
+
+/**
+ * A positional read or write of one or more CFAM words
+ */
+struct Transfer
+{
+    /**
+     * The file descriptor of the CFAM device
+     */
+    int fd;
+
+    /**
+     * If this is a write, otherwise it is a read
+     */
+    bool write;
+
+    /**
+     * The driver offset to start at
+     */
+    off_t offset;
+
+    /**
+     * The buffers to transfer to or from
+     */
+    std::vector<struct iovec> iov;
+
+    /**
+     * Filled in with the bytes transferred, or -errno
+     */
+    ssize_t result = 0;
+};
+
+/**
+ * @brief Runs a set of transfers and fills in their results.
+ *
+ * When io_uring is available all the transfers are in flight at the
+ * same time, so transfers to different chips take about as long as
+ * the slowest one.  Otherwise they are done one after the other with
+ * blocking preadv/pwritev calls.
+ *
+ * The transfers should not depend on each other.
+ *
+ * @param[in,out] transfers - The transfers to run
+ */
+void run(std::vector<Transfer>& transfers);
+
+/**
+ * Returns true if run() submits transfers through io_uring
+ */
+bool isAsync();
+
+} // namespace engine
+} // namespace cfam
+} // namespace openpower
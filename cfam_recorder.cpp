@@ -0,0 +1,257 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cfam_recorder.hpp"
+
+#include "filedescriptor.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace recorder
+{
+
+using namespace phosphor::logging;
+
+/**
+ * Returns the records that follow the header
+ */
+static inline Record* getRecords(Header* header)
+{
+    return reinterpret_cast<Record*>(header + 1);
+}
+
+static inline size_t fileSize(uint32_t capacity)
+{
+    return sizeof(Header) + (sizeof(Record) * capacity);
+}
+
+static inline bool isValid(const Header& header, size_t size)
+{
+    return (header.magic == ringMagic) && (header.version == ringVersion) &&
+           (header.recordSize == sizeof(Record)) && (header.capacity > 0) &&
+           (size == fileSize(header.capacity));
+}
+
+Recorder::Recorder(const std::string& path, uint32_t capacity)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(
+        std::filesystem::path{path}.parent_path(), ec);
+
+    int newFD = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (newFD < 0)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed opening " + path);
+    }
+    openpower::util::FileDescriptor fd{newFD};
+
+    // Other processes may be setting up the same file
+    if (flock(fd.get(), LOCK_EX) < 0)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed locking " + path);
+    }
+
+    struct stat st;
+    if (fstat(fd.get(), &st) < 0)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed checking " + path);
+    }
+
+    Header existing{};
+    bool reuse = (static_cast<size_t>(st.st_size) >= sizeof(Header)) &&
+                 (pread(fd.get(), &existing, sizeof(existing), 0) ==
+                  sizeof(existing)) &&
+                 isValid(existing, st.st_size);
+
+    size = reuse ? st.st_size : fileSize(capacity);
+
+    if (!reuse &&
+        ((ftruncate(fd.get(), 0) < 0) || (ftruncate(fd.get(), size) < 0)))
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed sizing " + path);
+    }
+
+    void* mapping =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+    if (mapping == MAP_FAILED)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed mapping " + path);
+    }
+
+    header = static_cast<Header*>(mapping);
+
+    if (!reuse)
+    {
+        header->version = ringVersion;
+        header->recordSize = sizeof(Record);
+        header->capacity = capacity;
+        header->written = 0;
+        header->magic = ringMagic;
+    }
+}
+
+Recorder::~Recorder()
+{
+    munmap(header, size);
+}
+
+void Recorder::record(uint16_t target, Type type, uint16_t address,
+                      uint32_t data, uint32_t mask, int error,
+                      std::chrono::steady_clock::time_point start)
+{
+    using namespace std::chrono;
+
+    auto latency = steady_clock::now() - start;
+    auto timestamp = system_clock::now() - latency;
+
+    // Claims a slot, even against other processes using the file
+    auto slot = std::atomic_ref<uint64_t>(header->written).fetch_add(1);
+
+    auto& entry = getRecords(header)[slot % header->capacity];
+    std::atomic_ref<uint64_t> sequence{entry.sequence};
+
+    // Marked unwritten first, so a reader skips it until it is whole
+    sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    entry.timestamp =
+        duration_cast<nanoseconds>(timestamp.time_since_epoch()).count();
+    entry.latency = std::min<int64_t>(
+        duration_cast<nanoseconds>(latency).count(), UINT32_MAX);
+    entry.data = data;
+    entry.mask = mask;
+    entry.error = error;
+    entry.target = target;
+    entry.address = address;
+    entry.type = type;
+
+    sequence.store(slot + 1, std::memory_order_release);
+}
+
+Recorder* Recorder::get()
+{
+    static std::unique_ptr<Recorder> recorder = []() {
+        std::unique_ptr<Recorder> newRecorder;
+
+        auto env = getenv(recordEnv);
+        if (env == nullptr)
+        {
+            return newRecorder;
+        }
+
+        std::string path = (env[0] == '/') ? env : defaultRecordPath;
+
+        try
+        {
+            newRecorder = std::make_unique<Recorder>(path);
+            log<level::INFO>("Recording CFAM accesses",
+                             entry("PATH=%s", path.c_str()));
+        }
+        catch (const std::system_error& e)
+        {
+            // Recording is for debug, so it must not stop a procedure
+            log<level::ERR>("Failed to start recording CFAM accesses",
+                            entry("ERROR=%s", e.what()));
+        }
+
+        return newRecorder;
+    }();
+
+    return recorder.get();
+}
+
+std::vector<Record> load(const std::string& path)
+{
+    std::ifstream file{path, std::ios::binary};
+    if (!file)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed opening " + path);
+    }
+
+    Header header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    auto size = std::filesystem::file_size(path);
+    if (!file || !isValid(header, size))
+    {
+        throw std::runtime_error(path + " is not a CFAM recording");
+    }
+
+    std::vector<Record> ring(header.capacity);
+    file.read(reinterpret_cast<char*>(ring.data()),
+              sizeof(Record) * ring.size());
+
+    // Slots that writers moved on to while the ring was being read
+    // may have been copied half replaced.
+    Header after{};
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(&after), sizeof(after));
+    if (!file)
+    {
+        throw std::runtime_error(path + " is not a CFAM recording");
+    }
+
+    // Once it has wrapped, the oldest record is the next to be replaced
+    std::vector<Record> records;
+    uint64_t count = std::min<uint64_t>(header.written, header.capacity);
+    uint64_t first = header.written - count;
+    if (after.written > header.capacity)
+    {
+        first = std::max(first, after.written - header.capacity);
+    }
+
+    records.reserve(count);
+    for (uint64_t i = first; i < header.written; i++)
+    {
+        // Skips ones that were still being written
+        const auto& record = ring[i % header.capacity];
+        if (record.sequence == i + 1)
+        {
+            records.push_back(record);
+        }
+    }
+
+    return records;
+}
+
+} // namespace recorder
+} // namespace cfam
+} // namespace openpower
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace recorder
+{
+
+/**
+ * Setting this environment variable turns on recording of every
+ * CFAM access.  It is the path of the ring file to append to, or
+ * anything else, like "1", to use defaultRecordPath.
+ */
+constexpr auto recordEnv = "OPENPOWER_CFAM_RECORD";
+
+constexpr auto defaultRecordPath = "/run/openpower-proc-control/cfam.rec";
+
+/**
+ * The number of records a new ring file holds before it wraps
+ */
+constexpr uint32_t defaultCapacity = 65536;
+
+/**
+ * The kind of access
+ */
+enum class Type : uint8_t
+{
+    read,
+    write,
+    writeWithMask
+};
+
+/**
+ * A recorded access, as stored in the ring file
+ */
+struct Record
+{
+    /**
+     * One more than the number of Records written before this one,
+     * stored last.  0 while it is being written, so a reader can
+     * tell a complete record from one that is torn or stale.
+     */
+    uint64_t sequence;
+
+    /**
+     * When the access started, in ns since the epoch
+     */
+    uint64_t timestamp;
+
+    /**
+     * How long the access took, in ns
+     */
+    uint32_t latency;
+
+    /**
+     * The data read or written
+     */
+    uint32_t data;
+
+    /**
+     * The mask of a masked write
+     */
+    uint32_t mask;
+
+    /**
+     * 0 on success, otherwise the errno of the failure
+     */
+    int32_t error;
+
+    /**
+     * The position of the Target
+     */
+    uint16_t target;
+
+    /**
+     * The register address
+     */
+    uint16_t address;
+
+    Type type;
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(Record) == 40);
+
+/**
+ * The start of a ring file, followed by capacity Records
+ */
+struct Header
+{
+    /**
+     * ringMagic
+     */
+    uint32_t magic;
+
+    uint16_t version;
+
+    /**
+     * sizeof(Record)
+     */
+    uint16_t recordSize;
+
+    /**
+     * The number of Records in the file
+     */
+    uint32_t capacity;
+
+    uint32_t reserved;
+
+    /**
+     * The number of Records ever written.  The next one goes in
+     * slot written % capacity.  Updated atomically, so several
+     * processes can append to the same file.
+     */
+    uint64_t written;
+
+    uint64_t reserved2;
+};
+
+static_assert(sizeof(Header) == 32);
+
+constexpr uint32_t ringMagic = 0x4D414643; // "CFAM"
+constexpr uint16_t ringVersion = 2;
+
+/**
+ * @class Recorder
+ *
+ * Appends CFAM accesses to a ring file that is memory mapped, so
+ * recording an access doesn't take a system call.
+ */
+class Recorder
+{
+  public:
+    /**
+     * Constructor
+     *
+     * Opens the ring file, creating it if it doesn't exist or
+     * doesn't have the expected layout.  Throws a std::system_error
+     * if that fails.
+     *
+     * @param[in] path - The ring file path
+     * @param[in] capacity - The number of records for a new file
+     */
+    explicit Recorder(const std::string& path,
+                      uint32_t capacity = defaultCapacity);
+
+    ~Recorder();
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+    Recorder(Recorder&&) = delete;
+    Recorder& operator=(Recorder&&) = delete;
+
+    /**
+     * @brief Appends an access
+     *
+     * @param[in] target - The position of the Target
+     * @param[in] type - The kind of access
+     * @param[in] address - The register address
+     * @param[in] data - The data read or written
+     * @param[in] mask - The mask of a masked write
+     * @param[in] error - 0, or the errno of the failure
+     * @param[in] start - When the access started
+     */
+    void record(uint16_t target, Type type, uint16_t address, uint32_t data,
+                uint32_t mask, int error,
+                std::chrono::steady_clock::time_point start);
+
+    /**
+     * Returns the process's recorder, or nullptr if recordEnv
+     * isn't set or the ring file couldn't be opened.
+     */
+    static Recorder* get();
+
+  private:
+    /**
+     * The mapped file
+     */
+    Header* header = nullptr;
+
+    /**
+     * The size of the mapping
+     */
+    size_t size = 0;
+};
+
+/**
+ * @brief Reads the records in a ring file, oldest first.
+ *
+ * Records that were being written, or were overwritten, while the
+ * file was read are left out.
+ *
+ * Throws a std::system_error if the file can't be read, or a
+ * std::runtime_error if it isn't a ring file.
+ *
+ * @param[in] path - The ring file path
+ * @return - The records
+ */
+std::vector<Record> load(const std::string& path);
+
+} // namespace recorder
+} // namespace cfam
+} // namespace openpower
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+
+namespace openpower
+{
+namespace cfam
+{
+
+/**
+ * Converts the CFAM register address used by the calling
+ * code (because that's how it is in the spec) to the address
+ * required by the device driver.
+ */
+constexpr uint16_t makeOffset(uint16_t address)
+{
+    return (address & 0xFC00) | ((address & 0x03FF) << 2);
+}
+
+/**
+ * How a register may be accessed
+ */
+enum class Mode
+{
+    readOnly,
+    writeOnly,
+    readWrite
+};
+
+/**
+ * The data and mask for a masked write of one or more fields.
+ * Values for several fields are combined with operator|.
+ */
+struct FieldValue
+{
+    uint32_t data;
+    uint32_t mask;
+
+    constexpr FieldValue operator|(const FieldValue& other) const
+    {
+        return {data | other.data, mask | other.mask};
+    }
+};
+
+/**
+ * A field within a 32 bit CFAM register.
+ *
+ * Bits are numbered like the spec, where bit 0 is the most
+ * significant bit.
+ *
+ * @tparam First - The first (most significant) bit of the field
+ * @tparam Width - The number of bits in the field
+ */
+template <unsigned First, unsigned Width>
+    requires((Width > 0) && (First + Width <= 32))
+struct Field
+{
+    static constexpr unsigned shift = 32 - First - Width;
+    static constexpr uint32_t mask =
+        static_cast<uint32_t>((uint64_t{1} << Width) - 1) << shift;
+
+    /**
+     * Returns the value of the field in a register value
+     */
+    static constexpr uint32_t get(uint32_t reg)
+    {
+        return (reg & mask) >> shift;
+    }
+
+    /**
+     * Returns the register value with the field set to value
+     */
+    static constexpr uint32_t insert(uint32_t reg, uint32_t value)
+    {
+        return (reg & ~mask) | ((value << shift) & mask);
+    }
+
+    /**
+     * Returns the data and mask for a masked write that
+     * sets the field to value.
+     */
+    constexpr FieldValue operator()(uint32_t value) const
+    {
+        return {(value << shift) & mask, mask};
+    }
+};
+
+/**
+ * Describes a CFAM register at compile time.
+ *
+ * Register definitions with named fields derive from this and
+ * add the fields as static constexpr Field members.
+ *
+ * @tparam Address - The register address, as it is in the spec
+ * @tparam Access - How the register may be accessed
+ */
+template <uint16_t Address, Mode Access = Mode::readWrite>
+struct Register
+{
+    static constexpr uint16_t address = Address;
+    static constexpr uint16_t offset = makeOffset(Address);
+    static constexpr Mode mode = Access;
+};
+
+/**
+ * Satisfied by the register descriptors
+ */
+template <typename T>
+concept CFAMRegister = requires {
+    { T::address } -> std::convertible_to<uint16_t>;
+    { T::offset } -> std::convertible_to<uint16_t>;
+    { T::mode } -> std::convertible_to<Mode>;
+};
+
+/**
+ * Satisfied by registers that may be read
+ */
+template <typename T>
+concept ReadableRegister = CFAMRegister<T> && (T::mode != Mode::writeOnly);
+
+/**
+ * Satisfied by registers that may be written
+ */
+template <typename T>
+concept WritableRegister = CFAMRegister<T> && (T::mode != Mode::readOnly);
+
+} // namespace cfam
+} // namespace openpower
@@ -0,0 +1,226 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cfam_access.hpp"
+#include "cfam_arbitration.hpp"
+#include "cfam_backend.hpp"
+#include "cfam_recorder.hpp"
+#include "targeting.hpp"
+
+#include <getopt.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <set>
+#include <string>
+
+/**
+ * Re-runs a CFAM recording made with OPENPOWER_CFAM_RECORD and prints
+ * how long each access took then and now.
+ *
+ * Accesses are replayed one at a time, so those that were recorded
+ * as part of a Batch have the time of their whole batch step
+ * recorded, not their own.
+ */
+
+using namespace openpower::cfam::access;
+using namespace openpower::cfam::backend;
+using namespace openpower::cfam::recorder;
+using namespace openpower::targeting;
+
+static void usage(char** argv)
+{
+    std::cerr << "Usage: " << argv[0] << " [--hardware] [--quiet] <file>\n"
+              << "  Replays against in-memory stand-in chips unless "
+                 "--hardware is given.\n";
+}
+
+static const char* typeName(Type type)
+{
+    switch (type)
+    {
+        case Type::read:
+            return "read";
+        case Type::write:
+            return "write";
+        case Type::writeWithMask:
+            return "wmask";
+    }
+
+    return "?";
+}
+
+/**
+ * Runs one access the way it was originally done
+ *
+ * @return 0 on success, else the errno
+ */
+static int replay(const std::unique_ptr<Target>& target, const Record& record)
+{
+    std::expected<cfam_data_t, AccessError> result;
+
+    switch (record.type)
+    {
+        case Type::read:
+            result = tryReadReg(target, record.address);
+            break;
+        case Type::write:
+            result = tryWriteReg(target, record.address, record.data);
+            break;
+        case Type::writeWithMask:
+            result = tryWriteRegWithMask(target, record.address, record.data,
+                                         record.mask);
+            break;
+    }
+
+    return result ? 0 : result.error().error;
+}
+
+int main(int argc, char** argv)
+{
+    bool hardware = false;
+    bool quiet = false;
+
+    const struct option longOptions[] = {
+        {"hardware", no_argument, nullptr, 'w'},
+        {"quiet", no_argument, nullptr, 'q'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+
+    int opt = 0;
+    while ((opt = getopt_long(argc, argv, "wqh", longOptions, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+            case 'w':
+                hardware = true;
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            default:
+                usage(argv);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind != argc - 1)
+    {
+        usage(argv);
+        return 1;
+    }
+
+    // Don't add the replay to a recording
+    unsetenv(recordEnv);
+
+    // Stand-in chips don't need to wait for the real ones
+    if (!hardware)
+    {
+        setenv(openpower::cfam::arbitration::priorityEnv, "off", 1);
+    }
+
+    std::vector<Record> records;
+    try
+    {
+        records = load(argv[optind]);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Target>> targetList;
+    if (!hardware)
+    {
+        std::set<uint16_t> positions;
+        for (const auto& record : records)
+        {
+            positions.insert(record.target);
+        }
+
+        for (auto pos : positions)
+        {
+            targetList.push_back(std::make_unique<Target>(
+                pos, std::make_unique<MemoryBackend>("memory" +
+                                                     std::to_string(pos))));
+        }
+    }
+
+    Targeting targets = hardware ? Targeting{}
+                                 : Targeting{std::move(targetList)};
+
+    double recordedTotal = 0;
+    double replayedTotal = 0;
+    size_t skipped = 0;
+    size_t mismatched = 0;
+
+    if (!quiet)
+    {
+        printf("%6s %4s %-5s %6s %10s %12s %12s %12s\n", "index", "proc",
+               "type", "addr", "data", "then(us)", "now(us)", "diff(us)");
+    }
+
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const auto& record = records[i];
+
+        std::unique_ptr<Target>* target = nullptr;
+        try
+        {
+            target = &targets.getTarget(record.target);
+        }
+        catch (const std::runtime_error&)
+        {
+            skipped++;
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto rc = replay(*target, record);
+        std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        double then = record.latency / 1000.0;
+        recordedTotal += then;
+        replayedTotal += elapsed.count();
+
+        bool mismatch = ((rc == 0) != (record.error == 0));
+        if (mismatch)
+        {
+            mismatched++;
+        }
+
+        if (!quiet)
+        {
+            printf("%6zu %4u %-5s 0x%04X 0x%08X %12.2f %12.2f %+12.2f%s\n",
+                   i, record.target, typeName(record.type), record.address,
+                   record.data, then, elapsed.count(),
+                   elapsed.count() - then,
+                   mismatch ? "  result differs" : "");
+        }
+    }
+
+    printf("\n%zu accesses replayed, %zu skipped for missing targets, "
+           "%zu with different results\n",
+           records.size() - skipped, skipped, mismatched);
+    printf("total then %.2fus, now %.2fus, diff %+.2fus\n", recordedTotal,
+           replayedTotal, replayedTotal - recordedTotal);
+
+    return 0;
+}
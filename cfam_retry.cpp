@@ -0,0 +1,203 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cfam_retry.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <optional>
+#include <sstream>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace retry
+{
+
+using namespace phosphor::logging;
+
+/**
+ * The errnos that can be given by name in the errnos setting
+ */
+static constexpr std::pair<const char*, int> errnoNames[] = {
+    {"EIO", EIO},         {"ETIMEDOUT", ETIMEDOUT}, {"EAGAIN", EAGAIN},
+    {"EBUSY", EBUSY},     {"ENXIO", ENXIO},         {"ENODEV", ENODEV},
+    {"EPROTO", EPROTO},   {"EREMOTEIO", EREMOTEIO}, {"ENOENT", ENOENT},
+    {"EINVAL", EINVAL},   {"EINTR", EINTR},
+};
+
+/**
+ * Returns the number in a setting, if it is one
+ */
+static std::optional<unsigned long> toNumber(const std::string& text)
+{
+    char* end = nullptr;
+    auto number = strtoul(text.c_str(), &end, 0);
+    if (text.empty() || (*end != '\0'))
+    {
+        return std::nullopt;
+    }
+
+    return number;
+}
+
+/**
+ * Returns the errno an errnos setting names, by name or number
+ */
+static std::optional<int> toErrno(const std::string& text)
+{
+    for (const auto& [name, err] : errnoNames)
+    {
+        if (text == name)
+        {
+            return err;
+        }
+    }
+
+    auto number = toNumber(text);
+    if (number && *number)
+    {
+        return static_cast<int>(*number);
+    }
+
+    return std::nullopt;
+}
+
+bool Policy::isRetryable(int err) const
+{
+    return std::find(errnos.begin(), errnos.end(), err) != errnos.end();
+}
+
+std::chrono::microseconds Policy::getDelay(unsigned retry) const
+{
+    auto sleep = delay;
+    for (unsigned i = 1; (i < retry) && (sleep < maxDelay); i++)
+    {
+        sleep *= factor;
+    }
+
+    return std::min(sleep, maxDelay);
+}
+
+Policy parse(const std::string& settings, const Policy& base)
+{
+    Policy policy = base;
+
+    std::istringstream stream{settings};
+    std::string setting;
+    while (std::getline(stream, setting, ','))
+    {
+        auto equals = setting.find('=');
+        auto name = setting.substr(0, equals);
+        auto value = (equals == std::string::npos) ? std::string{}
+                                                   : setting.substr(equals + 1);
+        auto number = toNumber(value);
+        bool valid = number.has_value();
+
+        if (name == "attempts")
+        {
+            valid = valid && (*number > 0);
+            policy.attempts = valid ? *number : policy.attempts;
+        }
+        else if (name == "delay")
+        {
+            policy.delay = valid ? std::chrono::microseconds(*number)
+                                 : policy.delay;
+        }
+        else if (name == "factor")
+        {
+            valid = valid && (*number > 0);
+            policy.factor = valid ? *number : policy.factor;
+        }
+        else if (name == "max")
+        {
+            policy.maxDelay = valid ? std::chrono::microseconds(*number)
+                                    : policy.maxDelay;
+        }
+        else if (name == "errnos")
+        {
+            std::vector<int> errnos;
+            std::istringstream names{value};
+            std::string errName;
+
+            valid = true;
+            while (valid && std::getline(names, errName, ':'))
+            {
+                auto err = toErrno(errName);
+                valid = err.has_value();
+                errnos.push_back(err.value_or(0));
+            }
+
+            if (valid)
+            {
+                policy.errnos = std::move(errnos);
+            }
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            // A typo mustn't stop a procedure
+            log<level::ERR>("Ignoring bad CFAM retry setting",
+                            entry("SETTING=%s", setting.c_str()));
+        }
+    }
+
+    return policy;
+}
+
+/**
+ * Returns the process's policy for changing
+ */
+static Policy& processPolicy()
+{
+    static Policy policy = []() {
+        auto env = getenv(retryEnv);
+        return env ? parse(env) : Policy{};
+    }();
+
+    return policy;
+}
+
+const Policy& getPolicy()
+{
+    return processPolicy();
+}
+
+void setPolicy(const Policy& policy)
+{
+    processPolicy() = policy;
+}
+
+void loadProcedurePolicy(const std::string& procedure)
+{
+    auto name = std::string{retryEnv} + "_" + procedure;
+
+    auto env = getenv(name.c_str());
+    if (env != nullptr)
+    {
+        setPolicy(parse(env, getPolicy()));
+    }
+}
+
+} // namespace retry
+} // namespace cfam
+} // namespace openpower
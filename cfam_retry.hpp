@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace retry
+{
+
+/**
+ * The retry policy of the process's CFAM accesses, as comma separated
+ * settings that override the defaults, such as
+ * "attempts=5,delay=500,factor=2,max=20000,errnos=EIO:ETIMEDOUT".
+ * The delays are in microseconds, and "attempts=1" turns retries off.
+ *
+ * This variable with "_" and a procedure name appended, such as
+ * OPENPOWER_CFAM_RETRY_startHost, overrides it for that procedure.
+ */
+constexpr auto retryEnv = "OPENPOWER_CFAM_RETRY";
+
+/**
+ * How a failed access is retried
+ */
+struct Policy
+{
+    /**
+     * The number of tries, including the first
+     */
+    unsigned attempts = 3;
+
+    /**
+     * The sleep before the first retry
+     */
+    std::chrono::microseconds delay{1000};
+
+    /**
+     * What each sleep is multiplied by for the next one
+     */
+    unsigned factor = 2;
+
+    /**
+     * The longest sleep
+     */
+    std::chrono::microseconds maxDelay{10000};
+
+    /**
+     * The errnos of transient failures.  Others, like ENODEV when
+     * the chip isn't there, would fail again.
+     */
+    std::vector<int> errnos{EIO, ETIMEDOUT, EAGAIN, EBUSY};
+
+    /**
+     * Returns true if a failure with the errno is retried
+     */
+    bool isRetryable(int err) const;
+
+    /**
+     * Returns the sleep before a retry, counting from 1
+     */
+    std::chrono::microseconds getDelay(unsigned retry) const;
+};
+
+/**
+ * @brief Applies settings in the retryEnv format to a policy.
+ *
+ * Settings that can't be parsed are logged and skipped.
+ *
+ * @param[in] settings - The settings
+ * @param[in] base - The policy to apply them to
+ * @return - The new policy
+ */
+Policy parse(const std::string& settings, const Policy& base = Policy{});
+
+/**
+ * Returns the process's policy, which is the defaults with retryEnv
+ * applied unless setPolicy() changed it.
+ */
+const Policy& getPolicy();
+
+/**
+ * @brief Changes the process's policy.
+ *
+ * It isn't synchronized with accesses, so it is for before they start.
+ *
+ * @param[in] policy - The new policy
+ */
+void setPolicy(const Policy& policy);
+
+/**
+ * @brief Applies the retryEnv override for a procedure, if there is
+ *        one, to the process's policy.
+ *
+ * @param[in] procedure - The procedure name
+ */
+void loadProcedurePolicy(const std::string& procedure);
+
+/**
+ * @brief Repeats a failed access with the process's policy.
+ *
+ * Sleeps before each retry, and calls onRetry first to count it.
+ *
+ * @param[in] err - 0, or the errno of the access that was done
+ * @param[in] access - Does the access again, returning 0 or the errno
+ * @param[in] onRetry - Called with the errno and the retry number,
+ *                      counting from 1, before each retry
+ * @return - 0, or the errno of the last try
+ */
+template <typename Access, typename OnRetry>
+int run(int err, Access&& access, OnRetry&& onRetry)
+{
+    if (!err)
+    {
+        return 0;
+    }
+
+    const auto& policy = getPolicy();
+    for (unsigned retry = 1;
+         err && (retry < policy.attempts) && policy.isRetryable(err); retry++)
+    {
+        onRetry(err, retry);
+        std::this_thread::sleep_for(policy.getDelay(retry));
+        err = access();
+    }
+
+    return err;
+}
+
+} // namespace retry
+} // namespace cfam
+} // namespace openpower
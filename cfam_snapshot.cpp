@@ -0,0 +1,243 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cfam_snapshot.hpp"
+
+#include "cfam_access.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <tuple>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace snapshot
+{
+
+using namespace openpower::cfam::access;
+using namespace openpower::targeting;
+
+static inline auto key(const Entry& entry)
+{
+    return std::tie(entry.target, entry.address);
+}
+
+std::vector<Range> loadRanges(const std::string& path)
+{
+    std::ifstream file{path};
+    if (!file)
+    {
+        throw std::runtime_error("Failed opening " + path);
+    }
+
+    std::vector<Range> ranges;
+    std::string line;
+    size_t number = 0;
+
+    while (std::getline(file, line))
+    {
+        number++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream fields{line};
+        std::string address;
+        std::string count = "1";
+        if (!(fields >> address))
+        {
+            continue;
+        }
+        fields >> count;
+
+        try
+        {
+            auto first = std::stoul(address, nullptr, 0);
+            auto size = std::stoul(count, nullptr, 0);
+            if ((size == 0) || (first + size > 0x10000))
+            {
+                throw std::out_of_range("Past the last register");
+            }
+
+            ranges.push_back(
+                {static_cast<uint16_t>(first), static_cast<uint16_t>(size)});
+        }
+        catch (const std::logic_error&)
+        {
+            throw std::runtime_error("Bad register range on line " +
+                                     std::to_string(number) + " of " + path);
+        }
+    }
+
+    return ranges;
+}
+
+Snapshot capture(Targeting& targets, const std::vector<Range>& ranges)
+{
+    using namespace std::chrono;
+
+    Snapshot snapshot;
+    snapshot.timestamp =
+        duration_cast<nanoseconds>(system_clock::now().time_since_epoch())
+            .count();
+
+    // A read of the same register on each Target in turn is one
+    // wave, so every chip is busy for the whole capture.
+    Batch batch;
+    std::vector<std::pair<Entry, size_t>> reads;
+
+    for (const auto& range : ranges)
+    {
+        for (uint32_t i = 0; i < range.count; i++)
+        {
+            uint16_t address = range.address + i;
+            for (const auto& target : targets)
+            {
+                Entry entry{static_cast<uint16_t>(target->getPos()), address,
+                            0, 0};
+                reads.emplace_back(entry, batch.read(target, address));
+            }
+        }
+    }
+
+    batch.submit();
+
+    snapshot.entries.reserve(reads.size());
+    for (auto& [entry, id] : reads)
+    {
+        const auto& result = batch.result(id);
+        entry.data = result.data;
+        entry.error = result.error;
+        snapshot.entries.push_back(entry);
+    }
+
+    std::stable_sort(snapshot.entries.begin(), snapshot.entries.end(),
+                     [](const auto& a, const auto& b) {
+                         return key(a) < key(b);
+                     });
+
+    return snapshot;
+}
+
+void save(const Snapshot& snapshot, const std::string& path)
+{
+    std::filesystem::path file{path};
+    std::error_code ec;
+    std::filesystem::create_directories(file.parent_path(), ec);
+
+    Header header{};
+    header.magic = snapshotMagic;
+    header.version = snapshotVersion;
+    header.entrySize = sizeof(Entry);
+    header.count = snapshot.entries.size();
+    header.timestamp = snapshot.timestamp;
+
+    // Written aside and renamed, so a reader never sees half of it
+    auto temp = path + ".tmp";
+    {
+        std::ofstream out{temp, std::ios::binary | std::ios::trunc};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(snapshot.entries.data()),
+                  sizeof(Entry) * snapshot.entries.size());
+        out.close();
+
+        if (!out)
+        {
+            // The stream doesn't say why, and errno may be stale
+            throw std::system_error(std::make_error_code(std::errc::io_error),
+                                    "Failed writing " + temp);
+        }
+    }
+
+    std::filesystem::rename(temp, file);
+}
+
+Snapshot load(const std::string& path)
+{
+    std::ifstream file{path, std::ios::binary};
+    if (!file)
+    {
+        throw std::system_error(errno, std::generic_category(),
+                                "Failed opening " + path);
+    }
+
+    Header header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    auto size = std::filesystem::file_size(path);
+    if (!file || (header.magic != snapshotMagic) ||
+        (header.version != snapshotVersion) ||
+        (header.entrySize != sizeof(Entry)) ||
+        (size != sizeof(Header) + (sizeof(Entry) * header.count)))
+    {
+        throw std::runtime_error(path + " is not a CFAM snapshot");
+    }
+
+    Snapshot snapshot;
+    snapshot.timestamp = header.timestamp;
+    snapshot.entries.resize(header.count);
+    file.read(reinterpret_cast<char*>(snapshot.entries.data()),
+              sizeof(Entry) * header.count);
+
+    return snapshot;
+}
+
+std::vector<Difference> diff(const Snapshot& before, const Snapshot& after)
+{
+    std::vector<Difference> differences;
+
+    // Both are in key order, so walk them together
+    auto old = before.entries.begin();
+    auto current = after.entries.begin();
+
+    while ((old != before.entries.end()) || (current != after.entries.end()))
+    {
+        if ((current == after.entries.end()) ||
+            ((old != before.entries.end()) && (key(*old) < key(*current))))
+        {
+            differences.push_back({old->target, old->address, *old, {}});
+            ++old;
+        }
+        else if ((old == before.entries.end()) || (key(*current) < key(*old)))
+        {
+            differences.push_back(
+                {current->target, current->address, {}, *current});
+            ++current;
+        }
+        else
+        {
+            if ((old->data != current->data) ||
+                (old->error != current->error))
+            {
+                differences.push_back(
+                    {old->target, old->address, *old, *current});
+            }
+            ++old;
+            ++current;
+        }
+    }
+
+    return differences;
+}
+
+} // namespace snapshot
+} // namespace cfam
+} // namespace openpower
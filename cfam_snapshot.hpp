@@ -0,0 +1,209 @@
+#pragma once
+
+#include "targeting.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace snapshot
+{
+
+/**
+ * Setting this environment variable makes snapshotCFAM capture the
+ * registers listed in that file instead of defaultRanges.  Each line
+ * is a register address and an optional count of the registers that
+ * follow it, like "0x2800 64".  '#' starts a comment.
+ */
+constexpr auto registersEnv = "OPENPOWER_CFAM_SNAPSHOT_REGS";
+
+constexpr auto snapshotPath = "/var/lib/openpower-proc-control/cfam.snap";
+
+/**
+ * Where the snapshot before the latest one is kept
+ */
+constexpr auto previousSnapshotPath =
+    "/var/lib/openpower-proc-control/cfam.snap.prev";
+
+/**
+ * A block of registers with consecutive addresses
+ */
+struct Range
+{
+    uint16_t address;
+    uint16_t count;
+};
+
+/**
+ * The registers captured by default: the FSI2PIB status and
+ * interrupt registers, the SBE and mailbox registers, and the
+ * root control registers.
+ */
+inline const std::vector<Range> defaultRanges{
+    {0x1007, 7}, {0x2800, 64}, {0x2910, 16}, {0x2980, 8}};
+
+/**
+ * A captured register, as stored in the snapshot file
+ */
+struct Entry
+{
+    /**
+     * The position of the Target
+     */
+    uint16_t target;
+
+    /**
+     * The register address
+     */
+    uint16_t address;
+
+    /**
+     * The register value, if it could be read
+     */
+    uint32_t data;
+
+    /**
+     * 0 on success, otherwise the errno of the failed read
+     */
+    int32_t error;
+};
+
+static_assert(sizeof(Entry) == 12);
+
+/**
+ * The start of a snapshot file, followed by count Entries
+ */
+struct Header
+{
+    /**
+     * snapshotMagic
+     */
+    uint32_t magic;
+
+    uint16_t version;
+
+    /**
+     * sizeof(Entry)
+     */
+    uint16_t entrySize;
+
+    /**
+     * The number of Entries in the file
+     */
+    uint32_t count;
+
+    uint32_t reserved;
+
+    /**
+     * When the snapshot was captured, in ns since the epoch
+     */
+    uint64_t timestamp;
+};
+
+static_assert(sizeof(Header) == 24);
+
+constexpr uint32_t snapshotMagic = 0x4E534643; // "CFSN"
+constexpr uint16_t snapshotVersion = 1;
+
+/**
+ * The registers of every Target at one point in time
+ */
+struct Snapshot
+{
+    /**
+     * When it was captured, in ns since the epoch
+     */
+    uint64_t timestamp = 0;
+
+    /**
+     * The registers, ordered by Target position and then address
+     */
+    std::vector<Entry> entries;
+};
+
+/**
+ * A register that differs between two snapshots
+ */
+struct Difference
+{
+    uint16_t target;
+    uint16_t address;
+
+    /**
+     * The register in the first snapshot, if it is in it
+     */
+    std::optional<Entry> before;
+
+    /**
+     * The register in the second snapshot, if it is in it
+     */
+    std::optional<Entry> after;
+};
+
+/**
+ * @brief Reads a register list in the registersEnv format.
+ *
+ * Throws a std::runtime_error if the file can't be read or
+ * has a line that can't be parsed.
+ *
+ * @param[in] path - The file path
+ * @return - The registers
+ */
+std::vector<Range> loadRanges(const std::string& path);
+
+/**
+ * @brief Reads registers from every Target.
+ *
+ * The reads are queued one register at a time across all the
+ * Targets, so each register is read from every chip at once.
+ * A failed read is stored with its errno instead of throwing.
+ *
+ * @param[in] targets - The Targets to read
+ * @param[in] ranges - The registers to read
+ * @return - The snapshot
+ */
+Snapshot capture(openpower::targeting::Targeting& targets,
+                 const std::vector<Range>& ranges);
+
+/**
+ * @brief Writes a snapshot file, replacing any existing one
+ *        atomically.
+ *
+ * Throws a std::system_error on failure.
+ *
+ * @param[in] snapshot - The snapshot
+ * @param[in] path - The file path
+ */
+void save(const Snapshot& snapshot, const std::string& path);
+
+/**
+ * @brief Reads a snapshot file.
+ *
+ * Throws a std::system_error if the file can't be read, or a
+ * std::runtime_error if it isn't a snapshot file.
+ *
+ * @param[in] path - The file path
+ * @return - The snapshot
+ */
+Snapshot load(const std::string& path);
+
+/**
+ * @brief Compares two snapshots.
+ *
+ * A register differs if its value or read error changed, or if
+ * it is only in one of the snapshots.
+ *
+ * @param[in] before - The older snapshot
+ * @param[in] after - The newer snapshot
+ * @return - The registers that differ, in Target and address order
+ */
+std::vector<Difference> diff(const Snapshot& before, const Snapshot& after);
+
+} // namespace snapshot
+} // namespace cfam
+} // namespace openpower
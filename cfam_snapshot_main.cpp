@@ -0,0 +1,121 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cfam_snapshot.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <optional>
+#include <string>
+
+/**
+ * Prints a CFAM snapshot made by the snapshotCFAM procedure, or only
+ * the registers that differ between two of them.
+ */
+
+using namespace openpower::cfam::snapshot;
+
+static void usage(char** argv)
+{
+    std::cerr << "Usage: " << argv[0] << " <file> [<newer file>]\n"
+              << "  Prints a snapshot, or what changed between two.\n";
+}
+
+/**
+ * Formats a register value, or its read failure
+ */
+static std::string format(const std::optional<Entry>& entry)
+{
+    char text[32];
+
+    if (!entry)
+    {
+        return "-";
+    }
+
+    if (entry->error)
+    {
+        snprintf(text, sizeof(text), "errno %d", entry->error);
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "0x%08X", entry->data);
+    }
+
+    return text;
+}
+
+static void printTime(const char* label, const Snapshot& snapshot)
+{
+    time_t seconds = snapshot.timestamp / 1000000000;
+    char text[64];
+    strftime(text, sizeof(text), "%F %T UTC", gmtime(&seconds));
+    printf("%s %s\n", label, text);
+}
+
+int main(int argc, char** argv)
+{
+    if ((argc < 2) || (argc > 3) || !strcmp(argv[1], "--help"))
+    {
+        usage(argv);
+        return 1;
+    }
+
+    Snapshot before;
+    std::optional<Snapshot> after;
+    try
+    {
+        before = load(argv[1]);
+        if (argc == 3)
+        {
+            after = load(argv[2]);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    if (!after)
+    {
+        printTime("captured", before);
+        printf("%4s %6s %12s\n", "proc", "addr", "value");
+        for (const auto& entry : before.entries)
+        {
+            printf("%4u 0x%04X %12s\n", entry.target, entry.address,
+                   format(entry).c_str());
+        }
+        return 0;
+    }
+
+    printTime("before", before);
+    printTime("after ", *after);
+
+    auto differences = diff(before, *after);
+    printf("%4s %6s %12s %12s\n", "proc", "addr", "before", "after");
+    for (const auto& d : differences)
+    {
+        printf("%4u 0x%04X %12s %12s\n", d.target, d.address,
+               format(d.before).c_str(), format(d.after).c_str());
+    }
+
+    printf("\n%zu registers differ\n", differences.size());
+
+    return 0;
+}
@@ -0,0 +1,306 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cfam_stats.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace stats
+{
+
+static constexpr const char* typeNames[] = {"read", "write", "writeWithMask"};
+
+static inline size_t index(Type type)
+{
+    return static_cast<size_t>(type);
+}
+
+/**
+ * Formats the upper bound of a latency bucket
+ */
+static std::string bucketLimit(size_t bucket)
+{
+    char text[32];
+    double ns = static_cast<double>(uint64_t{1} << bucket);
+
+    if (ns < 1000)
+    {
+        snprintf(text, sizeof(text), "<%.0fns", ns);
+    }
+    else if (ns < 1000000)
+    {
+        snprintf(text, sizeof(text), "<%.1fus", ns / 1000);
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "<%.1fms", ns / 1000000);
+    }
+
+    return text;
+}
+
+size_t AccessStats::toBucket(std::chrono::steady_clock::duration latency)
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(latency)
+                  .count();
+    if (ns <= 0)
+    {
+        return 0;
+    }
+
+    return std::min<size_t>(std::bit_width(static_cast<uint64_t>(ns)),
+                            latencyBuckets - 1);
+}
+
+/**
+ * Adds one attempt's latency to a type's total and buckets
+ */
+template <typename Counters>
+static void addLatency(Counters& c,
+                       std::chrono::steady_clock::duration latency)
+{
+    c.totalNs.fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count(),
+        std::memory_order_relaxed);
+    c.latency[AccessStats::toBucket(latency)].fetch_add(
+        1, std::memory_order_relaxed);
+}
+
+void AccessStats::record(Type type, int error,
+                         std::chrono::steady_clock::duration latency)
+{
+    auto& c = counters[index(type)];
+
+    c.count.fetch_add(1, std::memory_order_relaxed);
+    addLatency(c, latency);
+
+    if (error)
+    {
+        c.errors.fetch_add(1, std::memory_order_relaxed);
+        errnos[std::clamp(error, 0, maxErrno)].fetch_add(
+            1, std::memory_order_relaxed);
+    }
+}
+
+void AccessStats::recordLockWait(std::chrono::nanoseconds wait)
+{
+    uint64_t ns = wait.count();
+
+    lockCount.fetch_add(1, std::memory_order_relaxed);
+    lockWaitNs.fetch_add(ns, std::memory_order_relaxed);
+
+    auto max = lockMaxNs.load(std::memory_order_relaxed);
+    while ((ns > max) && !lockMaxNs.compare_exchange_weak(
+                             max, ns, std::memory_order_relaxed))
+    {}
+}
+
+uint64_t AccessStats::getLockCount() const
+{
+    return lockCount.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds AccessStats::getLockWait() const
+{
+    return std::chrono::nanoseconds(
+        lockWaitNs.load(std::memory_order_relaxed));
+}
+
+void AccessStats::recordRetry(Type type, int error,
+                              std::chrono::steady_clock::duration latency)
+{
+    auto& c = counters[index(type)];
+
+    c.retries.fetch_add(1, std::memory_order_relaxed);
+    addLatency(c, latency);
+    retryErrnos[std::clamp(error, 0, maxErrno)].fetch_add(
+        1, std::memory_order_relaxed);
+}
+
+uint64_t AccessStats::getRetries() const
+{
+    uint64_t total = 0;
+    for (const auto& c : counters)
+    {
+        total += c.retries.load(std::memory_order_relaxed);
+    }
+
+    return total;
+}
+
+uint64_t AccessStats::getRetryErrnoCount(int error) const
+{
+    return retryErrnos[std::clamp(error, 0, maxErrno)].load(
+        std::memory_order_relaxed);
+}
+
+uint64_t AccessStats::getCount(Type type) const
+{
+    return counters[index(type)].count.load(std::memory_order_relaxed);
+}
+
+uint64_t AccessStats::getErrors(Type type) const
+{
+    return counters[index(type)].errors.load(std::memory_order_relaxed);
+}
+
+uint64_t AccessStats::getErrnoCount(int error) const
+{
+    return errnos[std::clamp(error, 0, maxErrno)].load(
+        std::memory_order_relaxed);
+}
+
+uint64_t AccessStats::getLatencyCount(Type type, size_t bucket) const
+{
+    return counters[index(type)].latency.at(bucket).load(
+        std::memory_order_relaxed);
+}
+
+void AccessStats::dump(std::ostream& os) const
+{
+    os << "P" << pos << " " << path << "\n";
+
+    for (size_t t = 0; t < typeCount; t++)
+    {
+        const auto& c = counters[t];
+        auto count = c.count.load(std::memory_order_relaxed);
+        if (count == 0)
+        {
+            continue;
+        }
+
+        // A snapshot, so percentiles are only as exact as the buckets.
+        // The buckets have every attempt, retried ones included.
+        std::array<uint64_t, latencyBuckets> latency;
+        uint64_t total = 0;
+        for (size_t b = 0; b < latencyBuckets; b++)
+        {
+            latency[b] = c.latency[b].load(std::memory_order_relaxed);
+            total += latency[b];
+        }
+
+        auto percentile = [&latency, total](double p) {
+            uint64_t seen = 0;
+            for (size_t b = 0; b < latencyBuckets; b++)
+            {
+                seen += latency[b];
+                if (seen >= p * total)
+                {
+                    return bucketLimit(b);
+                }
+            }
+            return bucketLimit(latencyBuckets - 1);
+        };
+
+        char line[192];
+        snprintf(line, sizeof(line),
+                 "  %-14s count %llu errors %llu retries %llu avg %.2fus "
+                 "p50 %s p99 %s\n",
+                 typeNames[t], static_cast<unsigned long long>(count),
+                 static_cast<unsigned long long>(
+                     c.errors.load(std::memory_order_relaxed)),
+                 static_cast<unsigned long long>(
+                     c.retries.load(std::memory_order_relaxed)),
+                 c.totalNs.load(std::memory_order_relaxed) / 1000.0 /
+                     std::max<uint64_t>(total, 1),
+                 percentile(0.50).c_str(), percentile(0.99).c_str());
+        os << line;
+
+        os << "    latency";
+        for (size_t b = 0; b < latencyBuckets; b++)
+        {
+            if (latency[b])
+            {
+                os << " " << bucketLimit(b) << ":" << latency[b];
+            }
+        }
+        os << "\n";
+    }
+
+    auto locks = lockCount.load(std::memory_order_relaxed);
+    if (locks)
+    {
+        char line[128];
+        snprintf(line, sizeof(line),
+                 "  %-14s count %llu wait %.2fus max %.2fus\n", "lock",
+                 static_cast<unsigned long long>(locks),
+                 lockWaitNs.load(std::memory_order_relaxed) / 1000.0,
+                 lockMaxNs.load(std::memory_order_relaxed) / 1000.0);
+        os << line;
+    }
+
+    for (int e = 1; e <= maxErrno; e++)
+    {
+        auto count = errnos[e].load(std::memory_order_relaxed);
+        if (count)
+        {
+            os << "  errno " << e << ": " << count << "\n";
+        }
+    }
+
+    for (int e = 1; e <= maxErrno; e++)
+    {
+        auto count = retryErrnos[e].load(std::memory_order_relaxed);
+        if (count)
+        {
+            os << "  retried errno " << e << ": " << count << "\n";
+        }
+    }
+}
+
+/**
+ * The statistics of every chip, by position and path
+ */
+static std::map<std::pair<size_t, std::string>, std::shared_ptr<AccessStats>>
+    registry;
+
+static std::mutex registryMutex;
+
+std::shared_ptr<AccessStats> getStats(size_t position,
+                                      const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    auto& stats = registry[{position, path}];
+    if (!stats)
+    {
+        stats = std::make_shared<AccessStats>(position, path);
+    }
+
+    return stats;
+}
+
+void dumpAll(std::ostream& os)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    for (const auto& [key, stats] : registry)
+    {
+        stats->dump(os);
+    }
+}
+
+} // namespace stats
+} // namespace cfam
+} // namespace openpower
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "cfam_recorder.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace stats
+{
+
+/**
+ * Setting this environment variable makes openpower-proc-control dump
+ * the CFAM access statistics when a procedure exits.  It is the path
+ * of a file to write them to, or anything else, like "1", for stdout.
+ */
+constexpr auto statsEnv = "OPENPOWER_CFAM_STATS";
+
+using Type = openpower::cfam::recorder::Type;
+
+/**
+ * @class AccessStats
+ *
+ * Counts the CFAM accesses to one chip, their errors, and their
+ * latencies in power of two buckets.  The counters are atomics that
+ * are only ever added to, so recording never takes a lock.
+ */
+class AccessStats
+{
+  public:
+    /**
+     * The number of access types
+     */
+    static constexpr size_t typeCount = 3;
+
+    /**
+     * Latency bucket N counts accesses that took [2^(N-1), 2^N) ns,
+     * and the last one everything longer.
+     */
+    static constexpr size_t latencyBuckets = 32;
+
+    /**
+     * Errors are counted by errno up to this, and anything higher
+     * is counted with it.
+     */
+    static constexpr int maxErrno = 255;
+
+    /**
+     * Constructor
+     *
+     * @param[in] position - The position of the chip
+     * @param[in] path - The CFAM device path of the chip
+     */
+    AccessStats(size_t position, const std::string& path) :
+        pos(position), path(path)
+    {}
+
+    AccessStats(const AccessStats&) = delete;
+    AccessStats& operator=(const AccessStats&) = delete;
+
+    /**
+     * @brief Counts an access
+     *
+     * @param[in] type - The kind of access
+     * @param[in] error - 0, or the errno of the failure
+     * @param[in] latency - How long the last attempt at the access
+     *                      took, without any earlier retries
+     */
+    void record(Type type, int error,
+                std::chrono::steady_clock::duration latency);
+
+    /**
+     * Returns the number of accesses of a type
+     */
+    uint64_t getCount(Type type) const;
+
+    /**
+     * Returns the number of accesses of a type that failed
+     */
+    uint64_t getErrors(Type type) const;
+
+    /**
+     * Returns the number of accesses that failed with an errno, not
+     * counting failures that were retried
+     */
+    uint64_t getErrnoCount(int error) const;
+
+    /**
+     * Returns the count in a latency bucket for a type
+     */
+    uint64_t getLatencyCount(Type type, size_t bucket) const;
+
+    /**
+     * @brief Counts a wait for the arbitration lock on the chip
+     *
+     * @param[in] wait - How long it took to get the lock
+     */
+    void recordLockWait(std::chrono::nanoseconds wait);
+
+    /**
+     * Returns the number of times the lock was taken
+     */
+    uint64_t getLockCount() const;
+
+    /**
+     * Returns the total time spent waiting for the lock
+     */
+    std::chrono::nanoseconds getLockWait() const;
+
+    /**
+     * @brief Counts a retry of a failed attempt at an access
+     *
+     * The failure goes in its own errno counts, and the attempt's
+     * latency in the type's buckets, so neither is mixed up with
+     * how the access itself turned out.
+     *
+     * @param[in] type - The kind of access
+     * @param[in] error - The errno of the failed attempt
+     * @param[in] latency - How long the failed attempt took
+     */
+    void recordRetry(Type type, int error,
+                     std::chrono::steady_clock::duration latency);
+
+    /**
+     * Returns the number of retries
+     */
+    uint64_t getRetries() const;
+
+    /**
+     * Returns the number of retried failures with an errno
+     */
+    uint64_t getRetryErrnoCount(int error) const;
+
+    /**
+     * Returns the latency bucket for a duration
+     */
+    static size_t toBucket(std::chrono::steady_clock::duration latency);
+
+    /**
+     * Writes the non-zero statistics as text
+     */
+    void dump(std::ostream& os) const;
+
+  private:
+    struct Counters
+    {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> retries{0};
+        std::atomic<uint64_t> totalNs{0};
+        std::array<std::atomic<uint64_t>, latencyBuckets> latency{};
+    };
+
+    /**
+     * The position of the chip
+     */
+    size_t pos;
+
+    /**
+     * The CFAM device path of the chip
+     */
+    const std::string path;
+
+    /**
+     * The counters, indexed by Type
+     */
+    std::array<Counters, typeCount> counters;
+
+    /**
+     * The arbitration lock waits
+     */
+    std::atomic<uint64_t> lockCount{0};
+    std::atomic<uint64_t> lockWaitNs{0};
+    std::atomic<uint64_t> lockMaxNs{0};
+
+    /**
+     * The failed accesses, indexed by errno
+     */
+    std::array<std::atomic<uint64_t>, maxErrno + 1> errnos{};
+
+    /**
+     * The retried failures, indexed by errno
+     */
+    std::array<std::atomic<uint64_t>, maxErrno + 1> retryErrnos{};
+};
+
+/**
+ * @brief Returns the process wide statistics for a chip, creating
+ *        them if needed.
+ *
+ * Targets for the same chip share statistics, and they outlive the
+ * Targets so they can be dumped after a procedure is done.
+ *
+ * @param[in] position - The position of the chip
+ * @param[in] path - The CFAM device path of the chip
+ */
+std::shared_ptr<AccessStats> getStats(size_t position,
+                                      const std::string& path);
+
+/**
+ * Writes the statistics of every chip accessed by the process
+ */
+void dumpAll(std::ostream& os);
+
+} // namespace stats
+} // namespace cfam
+} // namespace openpower
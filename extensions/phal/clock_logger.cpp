@@ -16,6 +16,9 @@
 
 #include "extensions/phal/clock_logger.hpp"
 
+#include "cfam_arbitration.hpp"
+#include "extensions/phal/pdbg_utils.hpp"
+#include "extensions/phal/proc_index.hpp"
 #include "util.hpp"
 
 #include <attributes_info.H>
@@ -81,27 +84,23 @@ void Manager::createClockDataLog()
     // Data logger storage
     FFDCData clockDataLog;
 
-    struct pdbg_target* procTarget;
-    ATTR_HWAS_STATE_Type hwasState;
-    pdbg_for_each_class_target("proc", procTarget)
+    // The HWAS states can change between the daily logs
+    refreshProcs();
+
+    for (const auto& proc : getProcs())
     {
-        if (DT_GET_PROP(ATTR_HWAS_STATE, procTarget, hwasState))
-        {
-            error("{TARGET} Could not read HWAS_STATE attribute", "TARGET",
-                  pdbg_target_path(procTarget));
-            continue;
-        }
-        if (!hwasState.present)
+        if (!proc.present)
         {
             continue;
         }
 
-        auto index = std::to_string(pdbg_target_index(procTarget));
+        auto procTarget = proc.target;
+        auto index = std::to_string(proc.index);
 
         // update functional State
         std::string funState = "Non Functional";
 
-        if (hwasState.functional)
+        if (proc.functional)
         {
             funState = "Functional";
         }
@@ -110,11 +109,10 @@ void Manager::createClockDataLog()
         clockDataLog.push_back(std::make_pair(ssState.str(), funState));
 
         // update location code information
-        ATTR_LOCATION_CODE_Type locationCode;
-        memset(&locationCode, '\0', sizeof(locationCode));
+        std::string locationCode;
         try
         {
-            openpower::phal::pdbg::getLocationCode(procTarget, locationCode);
+            locationCode = getProcLocationCode(proc);
         }
         catch (const std::exception& e)
         {
@@ -140,7 +138,7 @@ void Manager::createClockDataLog()
         clockDataLog.push_back(std::make_pair(ssEC.str(), ssECVal.str()));
 
         // Add CFAM register information.
-        addCFAMData(procTarget, clockDataLog);
+        addCFAMData(proc, clockDataLog);
     }
 
     // Add clock register information
@@ -150,26 +148,31 @@ void Manager::createClockDataLog()
                               clockDataLog, Severity::Informational);
 }
 
-void Manager::addCFAMData(struct pdbg_target* proc,
+void Manager::addCFAMData(const Proc& proc,
                           openpower::pel::FFDCData& clockDataLog)
 {
     // collect Processor CFAM register data
     const std::vector<int> procCFAMAddr = {
         0x1007, 0x2804, 0x2810, 0x2813, 0x2814, 0x2815, 0x2816, 0x281D, 0x281E};
 
-    auto index = std::to_string(pdbg_target_index(proc));
+    auto index = std::to_string(proc.index);
+
+    // Holds off other processes for the whole set of reads, unless
+    // they are more urgent than this logger.  The lock is on the FSI
+    // position, like the procedures' Targets for the chip.
+    auto lock = openpower::cfam::arbitration::acquire(proc.position);
 
     for (int addr : procCFAMAddr)
     {
-        auto val = 0xDEADBEEF;
-        try
-        {
-            val = openpower::phal::pdbg::getCFAM(proc, addr);
-        }
-        catch (const std::exception& e)
+        // Retried on transient FSI errors, so a glitch doesn't leave
+        // a hole in the daily log.
+        uint32_t val = 0;
+        auto rc = openpower::phal::getCFAM(proc.target, addr, val);
+        if (rc)
         {
-            error("getCFAM on {TARGET} thrown exception({ERROR}): Addr ({REG})",
-                  "TARGET", pdbg_target_path(proc), "ERROR", e, "REG", addr);
+            error("getCFAM on {TARGET} failed({RC}): Addr ({REG})", "TARGET",
+                  pdbg_target_path(proc.target), "RC", rc, "REG", addr);
+            val = 0xDEADBEEF;
         }
         std::stringstream ssData;
         ssData << "0x" << std::setfill('0') << std::setw(8) << std::hex << val;
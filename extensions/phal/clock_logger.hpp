@@ -16,6 +16,7 @@
 #pragma once
 
 #include "extensions/phal/create_pel.hpp"
+#include "extensions/phal/proc_index.hpp"
 
 #include <sdeventplus/utility/timer.hpp>
 
@@ -67,11 +68,10 @@ class Manager
     /**
      * @brief Add processor specific CFAM data to daily logger.
      *
-     * @param[in] proc - pdbg processor target
+     * @param[in] proc - The processor
      * @param[out] ffdcData - reference to clock data log
      */
-    void addCFAMData(struct pdbg_target* proc,
-                     openpower::pel::FFDCData& clockDataLog);
+    void addCFAMData(const Proc& proc, openpower::pel::FFDCData& clockDataLog);
 
     /**
      * @brief Add clock specific register data to daily logger.
@@ -0,0 +1,75 @@
+extern "C"
+{
+#include <libpdbg.h>
+}
+
+#include "extensions/phal/pdbg_cfam_backend.hpp"
+
+#include "extensions/phal/pdbg_utils.hpp"
+#include "extensions/phal/proc_index.hpp"
+
+#include <phosphor-logging/log.hpp>
+
+#include <cerrno>
+
+namespace openpower
+{
+namespace phal
+{
+
+using namespace phosphor::logging;
+
+int PdbgCFAMBackend::open()
+{
+    // The processor index already walked the devtree for it
+    auto proc = findProc(procTarget);
+    fsiTarget = (proc && proc->fsi) ? proc->fsi : getFsiTarget(procTarget);
+    if (nullptr == fsiTarget)
+    {
+        return ENODEV;
+    }
+
+    if (probeTarget(procTarget))
+    {
+        // probe function logged details to journal
+        fsiTarget = nullptr;
+        return ENODEV;
+    }
+
+    return 0;
+}
+
+int PdbgCFAMBackend::read(uint16_t address, uint16_t /*offset*/,
+                          uint32_t& data)
+{
+    auto rc = fsi_read(fsiTarget, address, &data);
+    if (rc)
+    {
+        log<level::ERR>(
+            "failed to read cfam", entry("RC=%d", rc),
+            entry("CFAM=0x%X", address),
+            entry("FSI_TARGET_PATH=%s", pdbg_target_path(fsiTarget)));
+        return EIO;
+    }
+
+    return 0;
+}
+
+int PdbgCFAMBackend::write(uint16_t address, uint16_t /*offset*/,
+                           uint32_t data)
+{
+    auto rc = fsi_write(fsiTarget, address, data);
+    if (rc)
+    {
+        log<level::ERR>(
+            "failed to write cfam", entry("RC=%d", rc),
+            entry("CFAM=0x%X", address),
+            entry("FSI_TARGET_PATH=%s", pdbg_target_path(fsiTarget)));
+        return EIO;
+    }
+
+    return 0;
+}
+
+} // namespace phal
+} // namespace openpower
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "cfam_backend.hpp"
+
+extern "C"
+{
+#include <libpdbg.h>
+}
+
+#include <string>
+
+namespace openpower
+{
+namespace phal
+{
+
+/**
+ * @class PdbgCFAMBackend
+ *
+ * Accesses a processor's CFAM with pdbg's fsi_read() and fsi_write(),
+ * for when the devtree is already loaded.  Unlike getCFAM() and
+ * putCFAM(), the FSI target is only looked up and probed once.
+ */
+class PdbgCFAMBackend : public openpower::cfam::backend::Backend
+{
+  public:
+    /**
+     * Constructor
+     *
+     * @param[in] procTarget - The pdbg processor target
+     */
+    explicit PdbgCFAMBackend(struct pdbg_target* procTarget) :
+        procTarget(procTarget), path(pdbg_target_path(procTarget))
+    {}
+
+    int open() override;
+
+    int read(uint16_t address, uint16_t offset, uint32_t& data) override;
+
+    int write(uint16_t address, uint16_t offset, uint32_t data) override;
+
+    const std::string& getPath() const override
+    {
+        return path;
+    }
+
+  private:
+    /**
+     * The pdbg processor target
+     */
+    struct pdbg_target* procTarget;
+
+    /**
+     * The FSI target under the processor, found by open()
+     */
+    struct pdbg_target* fsiTarget = nullptr;
+
+    /**
+     * The devtree path of the processor target
+     */
+    const std::string path;
+};
+
+} // namespace phal
+} // namespace openpower
@@ -6,11 +6,19 @@ extern "C"
 #include "config.h"
 
 #include "extensions/phal/pdbg_utils.hpp"
+
+#include "cfam_arbitration.hpp"
+#include "cfam_retry.hpp"
 #include "extensions/phal/phal_error.hpp"
+#include "extensions/phal/proc_index.hpp"
+#include "tracing.hpp"
 
 #include <phosphor-logging/log.hpp>
 
 #include <format>
+#include <map>
+#include <mutex>
+#include <optional>
 
 namespace openpower
 {
@@ -38,7 +46,11 @@ pdbg_target* getFsiTarget(struct pdbg_target* procTarget)
     return fsiTarget;
 }
 
-uint32_t probeTarget(struct pdbg_target* procTarget)
+/**
+ * Returns the processor's PIB target once it is probed, or nullptr
+ * after logging why it couldn't be.
+ */
+static pdbg_target* getProbedPib(struct pdbg_target* procTarget)
 {
     struct pdbg_target* pibTarget = nullptr;
     pdbg_for_each_target("pib", procTarget, pibTarget)
@@ -51,7 +63,7 @@ uint32_t probeTarget(struct pdbg_target* procTarget)
         log<level::ERR>(
             "pib path of target not found",
             entry("PROC_TARGET_PATH=%s", pdbg_target_path(procTarget)));
-        return -1;
+        return nullptr;
     }
     // probe PIB and ensure it's enabled
     if (PDBG_TARGET_ENABLED != pdbg_target_probe(pibTarget))
@@ -59,35 +71,135 @@ uint32_t probeTarget(struct pdbg_target* procTarget)
         log<level::ERR>(
             "probe on pib target failed",
             entry("PIB_TARGET_PATH=%s", pdbg_target_path(pibTarget)));
-        return -1;
+        return nullptr;
     }
-    return 0;
+    return pibTarget;
 }
 
-uint32_t getCFAM(struct pdbg_target* procTarget, const uint32_t reg,
-                 uint32_t& val)
+uint32_t probeTarget(struct pdbg_target* procTarget)
+{
+    return getProbedPib(procTarget) ? 0 : -1;
+}
+
+/**
+ * A processor's FSI and probed PIB targets
+ */
+struct ProcTargets
+{
+    struct pdbg_target* fsi;
+    struct pdbg_target* pib;
+};
+
+/**
+ * Returns the FSI and PIB targets of a processor, finding and probing
+ * them on the first call for it.  The devtree is only loaded once per
+ * process, so they stay valid.  Failures aren't remembered, so a
+ * later call can probe again.
+ *
+ * @return the targets, or nothing if they couldn't be found or probed
+ */
+static std::optional<ProcTargets> findTargets(struct pdbg_target* procTarget)
 {
-    pdbg_target* fsiTarget = getFsiTarget(procTarget);
+    static std::map<struct pdbg_target*, ProcTargets> found;
+    static std::mutex mutex;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = found.find(procTarget);
+    if (it != found.end())
+    {
+        return it->second;
+    }
+
+    // Both log the details to the journal
+    auto fsiTarget = getFsiTarget(procTarget);
     if (nullptr == fsiTarget)
     {
-        log<level::ERR>("getCFAM: fsi path or target not found");
-        return -1;
+        return std::nullopt;
     }
 
-    auto rc = probeTarget(procTarget);
-    if (rc)
+    auto pibTarget = getProbedPib(procTarget);
+    if (nullptr == pibTarget)
     {
-        // probe function logged details to journal
-        return rc;
+        return std::nullopt;
     }
 
-    rc = fsi_read(fsiTarget, reg, &val);
+    ProcTargets targets{fsiTarget, pibTarget};
+    found.emplace(procTarget, targets);
+    return targets;
+}
+
+/**
+ * Locks a processor's chip for arbitration.  The lock is on its FSI
+ * position, like the Targets for the chip, so these accesses and
+ * Targeting's keep out of each other's way.
+ *
+ * @return the lock, or nothing if arbitration is off
+ */
+static std::optional<openpower::cfam::arbitration::Lock>
+    lockProc(struct pdbg_target* procTarget)
+{
+    auto proc = findProc(procTarget);
+    return openpower::cfam::arbitration::acquire(
+        proc ? proc->position : pdbg_target_index(procTarget));
+}
+
+/**
+ * Retries a failed libpdbg access with the CFAM retry policy.
+ * libpdbg doesn't give an errno, so failures count as EIO.
+ *
+ * @param[in] rc - The return code of the access that was done
+ * @param[in] access - Does the access again, returning its return code
+ *
+ * @return the return code of the last try
+ */
+template <typename Access>
+static int retryPdbg(struct pdbg_target* procTarget, uint32_t addr, int rc,
+                     Access&& access)
+{
+    auto err = openpower::cfam::retry::run(
+        rc ? EIO : 0,
+        [&]() {
+            rc = access();
+            return rc ? EIO : 0;
+        },
+        [&](int, unsigned retry) {
+            OPENPOWER_PROBE(pdbg__retry, pdbg_target_index(procTarget), addr,
+                            rc, retry);
+            log<level::INFO>(
+                "Retrying a failed pdbg CFAM access",
+                entry("PROC_TARGET_PATH=%s", pdbg_target_path(procTarget)),
+                entry("CFAM=0x%X", addr), entry("RC=%d", rc),
+                entry("RETRY=%u", retry));
+        });
+
+    return err ? rc : 0;
+}
+
+uint32_t getCFAM(struct pdbg_target* procTarget, const uint32_t reg,
+                 uint32_t& val)
+{
+    auto lock = lockProc(procTarget);
+    OPENPOWER_PROBE(pdbg__cfam__start, pdbg_target_index(procTarget), reg,
+                    false);
+
+    auto targets = findTargets(procTarget);
+    if (!targets)
+    {
+        log<level::ERR>("getCFAM: fsi or pib target not found or probed");
+        return -1;
+    }
+
+    auto rc = retryPdbg(procTarget, reg, fsi_read(targets->fsi, reg, &val),
+                        [&]() { return fsi_read(targets->fsi, reg, &val); });
+    OPENPOWER_PROBE(pdbg__cfam__done, pdbg_target_index(procTarget), reg,
+                    false, val, rc);
     if (rc)
     {
         log<level::ERR>(
             "failed to read input cfam", entry("RC=%u", rc),
             entry("CFAM=0x%X", reg),
-            entry("FSI_TARGET_PATH=%s", pdbg_target_path(fsiTarget)));
+            entry("FSI_TARGET_PATH=%s", pdbg_target_path(targets->fsi)));
         return rc;
     }
     return 0;
@@ -96,27 +208,27 @@ uint32_t getCFAM(struct pdbg_target* procTarget, const uint32_t reg,
 uint32_t putCFAM(struct pdbg_target* procTarget, const uint32_t reg,
                  const uint32_t val)
 {
-    pdbg_target* fsiTarget = getFsiTarget(procTarget);
-    if (nullptr == fsiTarget)
-    {
-        log<level::ERR>("putCFAM: fsi path or target not found");
-        return -1;
-    }
+    auto lock = lockProc(procTarget);
+    OPENPOWER_PROBE(pdbg__cfam__start, pdbg_target_index(procTarget), reg,
+                    true);
 
-    auto rc = probeTarget(procTarget);
-    if (rc)
+    auto targets = findTargets(procTarget);
+    if (!targets)
     {
-        // probe function logged details to journal
-        return rc;
+        log<level::ERR>("putCFAM: fsi or pib target not found or probed");
+        return -1;
     }
 
-    rc = fsi_write(fsiTarget, reg, val);
+    auto rc = retryPdbg(procTarget, reg, fsi_write(targets->fsi, reg, val),
+                        [&]() { return fsi_write(targets->fsi, reg, val); });
+    OPENPOWER_PROBE(pdbg__cfam__done, pdbg_target_index(procTarget), reg,
+                    true, val, rc);
     if (rc)
     {
         log<level::ERR>(
             "failed to write input cfam", entry("RC=%u", rc),
             entry("CFAM=0x%X", reg),
-            entry("FSI_TARGET_PATH=%s", pdbg_target_path(fsiTarget)));
+            entry("FSI_TARGET_PATH=%s", pdbg_target_path(targets->fsi)));
         return rc;
     }
     return 0;
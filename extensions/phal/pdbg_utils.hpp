@@ -7,6 +7,8 @@ extern "C"
 #include <libpdbg.h>
 }
 
+#include <cstdint>
+
 namespace openpower
 {
 namespace phal
@@ -48,8 +50,8 @@ pdbg_target* getFsiTarget(struct pdbg_target* procTarget);
 /**
  *  @brief  Helper function to probe the processor target
  *
- *  The probe call only has to happen once per application start so ensure
- *  this function only probes once no matter how many times it's called.
+ *  getCFAM() and putCFAM() only probe a processor the first time they
+ *  use it.
  *
  *  @param[in]  procTarget - Processor target to probe
  *
@@ -5,7 +5,7 @@ extern "C"
 
 #include "create_pel.hpp"
 #include "dump_utils.hpp"
-#include "extensions/phal/common_utils.hpp"
+#include "extensions/phal/proc_index.hpp"
 #include "phal_error.hpp"
 #include "util.hpp"
 
@@ -286,15 +286,9 @@ void processNonFunctionalBootProc()
     jsonCalloutDataList.emplace_back(std::move(jsonProcedCallout));
 
     // get primary processor
-    struct pdbg_target* procTarget;
-    pdbg_for_each_class_target("proc", procTarget)
-    {
-        if (openpower::phal::isPrimaryProc(procTarget))
-            break;
-        procTarget = nullptr;
-    }
+    const auto* primaryProc = openpower::phal::getPrimaryProc();
     // check valid primary processor is available
-    if (procTarget == nullptr)
+    if (primaryProc == nullptr)
     {
         log<level::ERR>(
             "processNonFunctionalBootProc: fail to get primary processor");
@@ -303,9 +297,9 @@ void processNonFunctionalBootProc()
     {
         try
         {
-            ATTR_LOCATION_CODE_Type locationCode = {'\0'};
             // Get location code information
-            openpower::phal::pdbg::getLocationCode(procTarget, locationCode);
+            auto locationCode =
+                openpower::phal::getProcLocationCode(*primaryProc);
             json jsonProcCallout;
             jsonProcCallout["LocationCode"] = locationCode;
             jsonProcCallout["Deconfigured"] = false;
@@ -316,7 +310,8 @@ void processNonFunctionalBootProc()
         catch (const std::exception& e)
         {
             log<level::ERR>(std::format("getLocationCode({}): Exception({})",
-                                        pdbg_target_path(procTarget), e.what())
+                                        pdbg_target_path(primaryProc->target),
+                                        e.what())
                                 .c_str());
         }
     }
@@ -880,13 +875,9 @@ void processSbeBootError()
     reset();
 
     // get primary processor to collect FFDC/Dump information.
-    struct pdbg_target* procTarget;
-    pdbg_for_each_class_target("proc", procTarget)
-    {
-        if (openpower::phal::isPrimaryProc(procTarget))
-            break;
-        procTarget = nullptr;
-    }
+    const auto* primaryProc = openpower::phal::getPrimaryProc();
+    struct pdbg_target* procTarget =
+        primaryProc ? primaryProc->target : nullptr;
     // check valid primary processor is available
     if (procTarget == nullptr)
     {
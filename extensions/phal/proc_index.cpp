@@ -0,0 +1,189 @@
+extern "C"
+{
+#include <libpdbg.h>
+}
+
+#include "extensions/phal/proc_index.hpp"
+
+#include <attributes_info.H>
+#include <libphal.H>
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+namespace openpower
+{
+namespace phal
+{
+
+using namespace phosphor::logging;
+
+/**
+ * The processors, and the location codes looked up so far
+ */
+struct Index
+{
+    std::vector<Proc> procs;
+    std::map<uint32_t, std::string> locationCodes;
+    std::mutex mutex;
+};
+
+static Index& getIndex()
+{
+    static Index index;
+    return index;
+}
+
+/**
+ * Returns the first child of a class under a target, or nullptr
+ */
+static struct pdbg_target* findChild(struct pdbg_target* parent,
+                                     const char* klass)
+{
+    struct pdbg_target* child = nullptr;
+    pdbg_for_each_target(klass, parent, child)
+    {
+        break;
+    }
+    return child;
+}
+
+/**
+ * Returns the FSI position of a processor, which for a processor
+ * behind the hub is the port of its hub FSI link
+ */
+static size_t getPosition(const Proc& proc)
+{
+    if (proc.primary)
+    {
+        return 0;
+    }
+
+    uint32_t port = 0;
+    if (proc.fsi && !pdbg_target_u32_property(proc.fsi, "port", &port))
+    {
+        return port;
+    }
+
+    return proc.index;
+}
+
+/**
+ * Finds the processors and reads their attributes
+ */
+static std::vector<Proc> findProcs()
+{
+    std::vector<Proc> procs;
+
+    struct pdbg_target* procTarget;
+    pdbg_for_each_class_target("proc", procTarget)
+    {
+        Proc proc{.target = procTarget,
+                  .index = pdbg_target_index(procTarget),
+                  .position = 0};
+
+        ATTR_PROC_MASTER_TYPE_Type type;
+        if (DT_GET_PROP(ATTR_PROC_MASTER_TYPE, procTarget, type))
+        {
+            log<level::ERR>(
+                "Attribute [ATTR_PROC_MASTER_TYPE] get failed",
+                entry("PROC_TARGET_PATH=%s", pdbg_target_path(procTarget)));
+        }
+        else
+        {
+            proc.primary = (type == ENUM_ATTR_PROC_MASTER_TYPE_ACTING_MASTER);
+        }
+
+        ATTR_HWAS_STATE_Type hwasState;
+        if (DT_GET_PROP(ATTR_HWAS_STATE, procTarget, hwasState))
+        {
+            log<level::ERR>(
+                "Could not read HWAS_STATE attribute",
+                entry("PROC_TARGET_PATH=%s", pdbg_target_path(procTarget)));
+        }
+        else
+        {
+            proc.present = hwasState.present;
+            proc.functional = hwasState.functional;
+        }
+
+        proc.fsi = findChild(procTarget, "fsi");
+        proc.pib = findChild(procTarget, "pib");
+        proc.position = getPosition(proc);
+
+        procs.push_back(proc);
+    }
+
+    return procs;
+}
+
+const std::vector<Proc>& getProcs()
+{
+    auto& index = getIndex();
+    std::lock_guard<std::mutex> lock(index.mutex);
+
+    // There are none until the devtree is loaded, so an empty
+    // index is looked for again.
+    if (index.procs.empty())
+    {
+        index.procs = findProcs();
+    }
+
+    return index.procs;
+}
+
+const Proc* getPrimaryProc()
+{
+    const auto& procs = getProcs();
+    auto proc = std::find_if(procs.begin(), procs.end(),
+                             [](const auto& p) { return p.primary; });
+
+    return (proc != procs.end()) ? &*proc : nullptr;
+}
+
+const Proc* findProc(struct pdbg_target* procTarget)
+{
+    const auto& procs = getProcs();
+    auto proc = std::find_if(
+        procs.begin(), procs.end(),
+        [procTarget](const auto& p) { return p.target == procTarget; });
+
+    return (proc != procs.end()) ? &*proc : nullptr;
+}
+
+std::string getProcLocationCode(const Proc& proc)
+{
+    auto& index = getIndex();
+    {
+        std::lock_guard<std::mutex> lock(index.mutex);
+        auto code = index.locationCodes.find(proc.index);
+        if (code != index.locationCodes.end())
+        {
+            return code->second;
+        }
+    }
+
+    // Throws on failure, which isn't remembered
+    ATTR_LOCATION_CODE_Type locationCode;
+    memset(&locationCode, '\0', sizeof(locationCode));
+    openpower::phal::pdbg::getLocationCode(proc.target, locationCode);
+
+    std::lock_guard<std::mutex> lock(index.mutex);
+    return index.locationCodes.emplace(proc.index, locationCode).first->second;
+}
+
+void refreshProcs()
+{
+    auto& index = getIndex();
+    std::lock_guard<std::mutex> lock(index.mutex);
+
+    index.procs = findProcs();
+    index.locationCodes.clear();
+}
+
+} // namespace phal
+} // namespace openpower
@@ -0,0 +1,105 @@
+#pragma once
+
+extern "C"
+{
+#include <libpdbg.h>
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openpower
+{
+namespace phal
+{
+
+/**
+ * A processor in the devtree, with what the procedures look up on it
+ */
+struct Proc
+{
+    struct pdbg_target* target;
+
+    /**
+     * The pdbg target index
+     */
+    uint32_t index;
+
+    /**
+     * The FSI position, which is the Target position used by
+     * Targeting and CFAM arbitration: 0 for the primary processor,
+     * and the hub link number for the others
+     */
+    size_t position;
+
+    /**
+     * If it is the primary (acting master) processor
+     */
+    bool primary = false;
+
+    /**
+     * From ATTR_HWAS_STATE, which are false if it couldn't be read
+     */
+    bool present = false;
+    bool functional = false;
+
+    /**
+     * The FSI and PIB targets under it, or nullptr if it has none.
+     * The PIB target isn't probed.
+     */
+    struct pdbg_target* fsi = nullptr;
+    struct pdbg_target* pib = nullptr;
+};
+
+/**
+ *  @brief  Returns the processors, in devtree order
+ *
+ *  They are found, and their attributes read, on the first call after
+ *  pdbg_targets_init(), and reused after that.  The attribute failures
+ *  are logged once, then.
+ *
+ *  @return The processors
+ */
+const std::vector<Proc>& getProcs();
+
+/**
+ *  @brief  Returns the primary processor
+ *
+ *  @return The processor, or nullptr if there isn't one
+ */
+const Proc* getPrimaryProc();
+
+/**
+ *  @brief  Returns the processor of a pdbg target
+ *
+ *  @param[in]  procTarget - Processor target
+ *
+ *  @return The processor, or nullptr if it isn't one
+ */
+const Proc* findProc(struct pdbg_target* procTarget);
+
+/**
+ *  @brief  Returns the location code of a processor, which is only
+ *          looked up the first time
+ *
+ *  Throws an exception if it can't be looked up.
+ *
+ *  @param[in]  proc - The processor
+ *
+ *  @return The location code
+ */
+std::string getProcLocationCode(const Proc& proc);
+
+/**
+ *  @brief  Finds the processors and reads their attributes again, for
+ *          after the devtree attributes were changed, like by an IPL
+ *
+ *  The references getProcs() and the others returned before are no
+ *  longer valid, so this must not be called while they are in use.
+ */
+void refreshProcs();
+
+} // namespace phal
+} // namespace openpower
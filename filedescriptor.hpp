@@ -32,6 +32,14 @@ class FileDescriptor
      */
     FileDescriptor(const std::string& path);
 
+    /**
+     * Takes ownership of a file descriptor that is
+     * already open.
+     *
+     * @param fd[in] - the open file descriptor
+     */
+    explicit FileDescriptor(int fd) : fd(fd) {}
+
     /**
      * Closes the file.
      */
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "cfam_register.hpp"
+
 namespace openpower
 {
 namespace cfam
@@ -7,8 +9,14 @@ namespace cfam
 namespace p10
 {
 
-static constexpr uint16_t P10_ROOT_CTRL8 = 0x2818;
-static constexpr uint16_t P10_SCRATCH_REG_12 = 0x2983;
+// Root control register 8
+struct RootCtrl8Reg : Register<0x2818>
+{
+    static constexpr Field<0, 4> spiMuxSelect{};
+};
+
+inline constexpr RootCtrl8Reg P10_ROOT_CTRL8{};
+inline constexpr Register<0x2983> P10_SCRATCH_REG_12{};
 
 } // namespace p10
 } // namespace cfam
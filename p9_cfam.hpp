@@ -1,5 +1,7 @@
 #pragma once
 
+#include "cfam_register.hpp"
+
 namespace openpower
 {
 namespace cfam
@@ -9,20 +11,74 @@ namespace p9
 
 static constexpr uint32_t P9_DD10_CHIPID = 0x120D1049;
 
-static constexpr uint16_t P9_FSI_A_SI1S = 0x081C;
-static constexpr uint16_t P9_LL_MODE_REG = 0x0840;
-static constexpr uint16_t P9_FSI2PIB_CHIPID = 0x100A;
-static constexpr uint16_t P9_FSI2PIB_INTERRUPT = 0x100B;
-static constexpr uint16_t P9_FSI2PIB_TRUE_MASK = 0x100D;
-static constexpr uint16_t P9_CBS_CS = 0x2801;
-static constexpr uint16_t P9_SBE_CTRL_STATUS = 0x2808;
-static constexpr uint16_t P9_SBE_MSG_REGISTER = 0x2809;
-static constexpr uint16_t P9_ROOT_CTRL0 = 0x2810;
-static constexpr uint16_t P9_PERV_CTRL0 = 0x281A;
-static constexpr uint16_t P9_HB_MBX5_REG = 0x283C;
-static constexpr uint16_t P9_SCRATCH_REGISTER_8 = 0x283F;
-static constexpr uint16_t P9_ROOT_CTRL8 = 0x2918;
-static constexpr uint16_t P9_ROOT_CTRL1_CLEAR = 0x2931;
+// Link layer mode register
+struct LLModeReg : Register<0x0840>
+{
+    static constexpr Field<31, 1> asyncClockMode{};
+};
+
+// CBS control/status register
+struct CBSCSReg : Register<0x2801>
+{
+    static constexpr Field<0, 1> startSBE{};
+};
+
+// SBE control/status register
+struct SBECtrlStatusReg : Register<0x2808>
+{
+    static constexpr Field<17, 1> seepromSide{};
+};
+
+// SBE messaging register
+struct SBEMsgReg : Register<0x2809>
+{
+    static constexpr Field<0, 1> sbeBooted{};
+    static constexpr Field<1, 1> asyncFFDC{};
+    static constexpr Field<4, 4> prevState{};
+    static constexpr Field<8, 4> currState{};
+    static constexpr Field<12, 8> majorStep{};
+    static constexpr Field<20, 6> minorStep{};
+};
+
+// HB mailbox scratch register 5
+struct HBMbx5Reg : Register<0x283C>
+{
+    static constexpr Field<0, 8> magic{};
+    static constexpr Field<8, 1> stepStart{};
+    static constexpr Field<9, 1> stepFinish{};
+    static constexpr Field<12, 4> internalStep{};
+    static constexpr Field<16, 8> majorStep{};
+    static constexpr Field<24, 8> minorStep{};
+};
+
+// FSI2PIB chip ID register
+struct ChipIdReg : Register<0x100A, Mode::readOnly>
+{
+    static constexpr Field<0, 4> majorEC{};
+    static constexpr Field<8, 4> minorEC{};
+    static constexpr Field<12, 8> chipType{};
+};
+
+// Root control register 8
+struct RootCtrl8Reg : Register<0x2918>
+{
+    static constexpr Field<28, 2> clockMuxSelectOverride{};
+};
+
+inline constexpr Register<0x081C> P9_FSI_A_SI1S{};
+inline constexpr LLModeReg P9_LL_MODE_REG{};
+inline constexpr ChipIdReg P9_FSI2PIB_CHIPID{};
+inline constexpr Register<0x100B> P9_FSI2PIB_INTERRUPT{};
+inline constexpr Register<0x100D> P9_FSI2PIB_TRUE_MASK{};
+inline constexpr CBSCSReg P9_CBS_CS{};
+inline constexpr SBECtrlStatusReg P9_SBE_CTRL_STATUS{};
+inline constexpr SBEMsgReg P9_SBE_MSG_REGISTER{};
+inline constexpr Register<0x2810> P9_ROOT_CTRL0{};
+inline constexpr Register<0x281A> P9_PERV_CTRL0{};
+inline constexpr HBMbx5Reg P9_HB_MBX5_REG{};
+inline constexpr Register<0x283F> P9_SCRATCH_REGISTER_8{};
+inline constexpr RootCtrl8Reg P9_ROOT_CTRL8{};
+inline constexpr Register<0x2931, Mode::writeOnly> P9_ROOT_CTRL1_CLEAR{};
 } // namespace p9
 } // namespace cfam
 } // namespace openpower
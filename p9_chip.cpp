@@ -0,0 +1,52 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "p9_chip.hpp"
+
+#include "cfam_access.hpp"
+#include "p9_cfam.hpp"
+
+namespace openpower
+{
+namespace cfam
+{
+namespace p9
+{
+
+using namespace openpower::targeting;
+
+ChipInfo getChipInfo(const std::unique_ptr<Target>& target)
+{
+    auto info = target->getChipInfo();
+    if (!info)
+    {
+        auto chipId = access::readReg(target, P9_FSI2PIB_CHIPID);
+
+        info.emplace();
+        info->chipId = chipId;
+        info->type = ChipIdReg::chipType.get(chipId);
+        info->ec = (ChipIdReg::majorEC.get(chipId) << 4) |
+                   ChipIdReg::minorEC.get(chipId);
+        info->master = (target->getPos() == 0);
+
+        target->setChipInfo(*info);
+    }
+
+    return *info;
+}
+
+} // namespace p9
+} // namespace cfam
+} // namespace openpower
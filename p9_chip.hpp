@@ -0,0 +1,30 @@
+#pragma once
+
+#include "targeting.hpp"
+
+#include <memory>
+
+namespace openpower
+{
+namespace cfam
+{
+namespace p9
+{
+
+/**
+ * @brief Returns the identity of a chip.
+ *
+ * The chip ID register is only read the first time, and the
+ * Target keeps the result for later calls.
+ *
+ * Throws an exception if the register can't be read.
+ *
+ * @param[in] target - The Target to get it for
+ * @return - The chip ID, type, EC level and if it is the master
+ */
+openpower::targeting::ChipInfo
+    getChipInfo(const std::unique_ptr<openpower::targeting::Target>& target);
+
+} // namespace p9
+} // namespace cfam
+} // namespace openpower
@@ -13,7 +13,10 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cfam_retry.hpp"
+#include "cfam_stats.hpp"
 #include "registration.hpp"
+#include "tracing.hpp"
 
 #include <org/open_power/Proc/FSI/error.hpp>
 #include <phosphor-logging/elog-errors.hpp>
@@ -24,6 +27,8 @@
 #include <xyz/openbmc_project/Common/error.hpp>
 
 #include <algorithm>
+#include <cstdlib>
+#include <fstream>
 #include <functional>
 #include <iostream>
 
@@ -45,30 +50,42 @@ void usage(char** argv, const ProcedureMap& procedures)
     }
 }
 
-int main(int argc, char** argv)
+/**
+ * Dumps the CFAM access statistics, if statsEnv asks for them
+ */
+void dumpStats()
 {
-    using namespace phosphor::logging;
-    const ProcedureMap& procedures = Registration::getProcedures();
+    using namespace openpower::cfam::stats;
 
-    if (argc != 2)
+    auto env = getenv(statsEnv);
+    if (env == nullptr)
     {
-        usage(argv, procedures);
-        return -1;
+        return;
     }
 
-    std::string action{argv[1]};
-
-    auto procedure = procedures.find(action);
-
-    if (procedure == procedures.end())
+    if (env[0] == '/')
     {
-        usage(argv, procedures);
-        return -1;
+        std::ofstream file{env, std::ios::app};
+        dumpAll(file);
+    }
+    else
+    {
+        dumpAll(std::cout);
     }
+}
+
+/**
+ * Runs a procedure, committing an error log for the errors it throws
+ *
+ * @return 0 on success, else -1
+ */
+int runProcedure(const ProcedureFunction& procedure)
+{
+    using namespace phosphor::logging;
 
     try
     {
-        procedure->second();
+        procedure();
     }
     catch (const file_error::Seek& e)
     {
@@ -113,3 +130,36 @@ int main(int argc, char** argv)
 
     return 0;
 }
+
+int main(int argc, char** argv)
+{
+    const ProcedureMap& procedures = Registration::getProcedures();
+
+    std::atexit(dumpStats);
+
+    if (argc != 2)
+    {
+        usage(argv, procedures);
+        return -1;
+    }
+
+    std::string action{argv[1]};
+
+    auto procedure = procedures.find(action);
+
+    if (procedure == procedures.end())
+    {
+        usage(argv, procedures);
+        return -1;
+    }
+
+    openpower::cfam::retry::loadProcedurePolicy(action);
+
+    OPENPOWER_PROBE(procedure__start, action.c_str());
+
+    auto rc = runProcedure(procedure->second);
+
+    OPENPOWER_PROBE(procedure__done, action.c_str(), rc);
+
+    return rc;
+}
@@ -39,39 +39,57 @@ void CFAMOverride()
 
     std::ifstream overrides("/var/lib/obmc/cfam_overrides");
 
+    // Lines for different processors can go out at the same time,
+    // and the first failure stops the rest like it always has.
+    Batch batch{Batch::Policy::stopOnError};
+
     if (overrides.is_open())
     {
-        while (std::getline(overrides, line))
+        try
         {
-            if (!line.empty())
+            while (std::getline(overrides, line))
             {
-                line.erase(0, line.find_first_not_of(" \t\r\n"));
-                if (!line.empty() && line.at(0) != '#')
+                if (!line.empty())
                 {
-                    mask = 0xFFFFFFFF;
-                    if (sscanf(line.c_str(), "%zu %hx %x %x", &pos, &address,
-                               &data, &mask) >= 3)
-                    {
-                        const auto& target = targets.getTarget(pos);
-                        writeRegWithMask(target, address, data, mask);
-                    }
-                    else
+                    line.erase(0, line.find_first_not_of(" \t\r\n"));
+                    if (!line.empty() && line.at(0) != '#')
                     {
-                        namespace error =
-                            sdbusplus::xyz::openbmc_project::Common::Error;
-                        namespace metadata =
-                            phosphor::logging::xyz::openbmc_project::Common;
-                        phosphor::logging::elog<error::InvalidArgument>(
-                            metadata::InvalidArgument::ARGUMENT_NAME("line"),
-                            metadata::InvalidArgument::ARGUMENT_VALUE(
-                                line.c_str()));
+                        mask = 0xFFFFFFFF;
+                        if (sscanf(line.c_str(), "%zu %hx %x %x", &pos,
+                                   &address, &data, &mask) >= 3)
+                        {
+                            const auto& target = targets.getTarget(pos);
+                            batch.writeWithMask(target, address, data, mask);
+                        }
+                        else
+                        {
+                            namespace error =
+                                sdbusplus::xyz::openbmc_project::Common::Error;
+                            namespace metadata = phosphor::logging::xyz::
+                                openbmc_project::Common;
+                            phosphor::logging::elog<error::InvalidArgument>(
+                                metadata::InvalidArgument::ARGUMENT_NAME(
+                                    "line"),
+                                metadata::InvalidArgument::ARGUMENT_VALUE(
+                                    line.c_str()));
+                        }
                     }
                 }
             }
         }
+        catch (...)
+        {
+            // The lines before the bad one still get applied
+            batch.submit();
+            batch.check();
+            throw;
+        }
         overrides.close();
     }
 
+    batch.submit();
+    batch.check();
+
     return;
 }
 
@@ -3,6 +3,7 @@
 #include <gpiod.hpp>
 #include <phosphor-logging/log.hpp>
 #include <registration.hpp>
+#include <targeting.hpp>
 
 #include <chrono>
 #include <fstream>
@@ -17,6 +18,8 @@ namespace misc
 constexpr auto cfamResetPath = "/sys/class/fsi-master/fsi0/device/cfam_reset";
 
 using namespace phosphor::logging;
+using openpower::targeting::Target;
+using openpower::targeting::Targeting;
 
 /**
  * @brief Reset the CFAM using the appropriate GPIO
@@ -39,6 +42,11 @@ void cfamReset()
         file << "1";
         file.close();
         log<level::DEBUG>("cfam reset via sysfs complete");
+
+        // Any register values shadowed before the reset are stale,
+        // and so are the devices found before it
+        Target::invalidateAllCaches();
+        Targeting::invalidateTopology();
         return;
     }
 
@@ -66,6 +74,11 @@ void cfamReset()
 
     // Take chips out of reset
     line.set_value(1);
+
+    // Any register values shadowed before the reset are stale,
+    // and so are the devices found before it
+    Target::invalidateAllCaches();
+    Targeting::invalidateTopology();
 }
 
 REGISTER_PROCEDURE("cfamReset", cfamReset)
@@ -20,67 +20,15 @@
 
 #include <phosphor-logging/log.hpp>
 
+#include <utility>
+#include <vector>
+
 namespace openpower
 {
 namespace p9
 {
 namespace debug
 {
-// SBE messaging register - cfam 2809
-union sbeMsgReg_t
-{
-    uint32_t data32;
-
-    struct
-    {
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-        uint32_t reserved2:6;
-        uint32_t minorStep:6;
-        uint32_t majorStep:8;
-        uint32_t currState:4;
-        uint32_t prevState:4;
-        uint32_t reserved1:2;
-        uint32_t asyncFFDC:1;
-        uint32_t sbeBooted:1;
-#else
-        uint32_t sbeBooted:1;
-        uint32_t asyncFFDC:1;
-        uint32_t reserved1:2;
-        uint32_t prevState:4;
-        uint32_t currState:4;
-        uint32_t majorStep:8;
-        uint32_t minorStep:6;
-        uint32_t reserved2:6;
-#endif
-    } PACK;
-};
-
-// HB mailbox scratch register 5 - cfam 283C
-union MboxScratch5_HB_t
-{
-    uint32_t data32;
-    struct
-    {
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-        uint32_t minorStep:8;    // 24:31
-        uint32_t majorStep:8;    // 16:23
-        uint32_t internalStep:4; // 12:15
-        uint32_t reserved:2;     // 10:11
-        uint32_t stepFinish:1;   // 9
-        uint32_t stepStart:1;    // 8
-        uint32_t magic:8;        // 0:7
-#else
-        uint32_t magic:8;        // 0:7
-        uint32_t stepStart:1;    // 8
-        uint32_t stepFinish:1;   // 9
-        uint32_t reserved:2;     // 10:11
-        uint32_t internalStep:4; // 12:15
-        uint32_t majorStep:8;    // 16:23
-        uint32_t minorStep:8;    // 24:31
-#endif
-    } PACK;
-};
-
 static constexpr uint8_t HB_MBX5_VALID_FLAG = 0xAA;
 
 /**
@@ -95,46 +43,59 @@ void collectSBEHBData()
     using namespace phosphor::logging;
 
     Targeting targets;
+    const auto& master = *(targets.begin());
+
+    // Queue every read up front so they can go out together, and
+    // a failure on one proc doesn't stop the others being captured.
+    Batch batch;
 
+    std::vector<std::pair<size_t, size_t>> sbeReads;
     for (const auto& proc : targets)
     {
-        // Read and parse SBE messaging register
-        try
-        {
-            auto readData = readReg(proc, P9_SBE_MSG_REGISTER);
-            auto msg = reinterpret_cast<const sbeMsgReg_t*>(&readData);
-            log<level::INFO>("SBE status register",
-                             entry("PROC=%d", proc->getPos()),
-                             entry("SBE_MAJOR_ISTEP=%d", msg->PACK.majorStep),
-                             entry("SBE_MINOR_ISTEP=%d", msg->PACK.minorStep),
-                             entry("REG_VAL=0x%08X", msg->data32));
-        }
-        catch (const std::exception& e)
-        {
-            log<level::ERR>(e.what());
-            // We want to continue - capturing as much info as possible
-        }
+        sbeReads.emplace_back(proc->getPos(),
+                              batch.read(proc, P9_SBE_MSG_REGISTER));
     }
 
-    const auto& master = *(targets.begin());
-    // Read and parse HB messaging register
-    try
+    auto hbRead = batch.read(master, P9_HB_MBX5_REG);
+
+    batch.submit();
+
+    // The failures are logged together at the end, and we want
+    // to continue - capturing as much info as possible
+    ErrorSummary errors;
+
+    // Parse SBE messaging register
+    for (const auto& [pos, id] : sbeReads)
     {
-        auto readData = readReg(master, P9_HB_MBX5_REG);
-        auto msg = reinterpret_cast<const MboxScratch5_HB_t*>(&readData);
-        if (HB_MBX5_VALID_FLAG == msg->PACK.magic)
+        auto data = batch.value(id);
+        if (!errors.check(data))
         {
-            log<level::INFO>("HB MBOX 5 register",
-                             entry("HB_MAJOR_ISTEP=%d", msg->PACK.majorStep),
-                             entry("HB_MINOR_ISTEP=%d", msg->PACK.minorStep),
-                             entry("REG_VAL=0x%08X", msg->data32));
+            continue;
         }
+
+        const auto& msg = P9_SBE_MSG_REGISTER;
+        log<level::INFO>("SBE status register", entry("PROC=%d", pos),
+                         entry("SBE_MAJOR_ISTEP=%d", msg.majorStep.get(*data)),
+                         entry("SBE_MINOR_ISTEP=%d", msg.minorStep.get(*data)),
+                         entry("REG_VAL=0x%08X", *data));
     }
-    catch (const std::exception& e)
+
+    // Parse HB messaging register
+    auto data = batch.value(hbRead);
+    if (errors.check(data))
     {
-        log<level::ERR>(e.what());
-        // We want to continue - capturing as much info as possible
+        const auto& msg = P9_HB_MBX5_REG;
+        if (HB_MBX5_VALID_FLAG == msg.magic.get(*data))
+        {
+            log<level::INFO>(
+                "HB MBOX 5 register",
+                entry("HB_MAJOR_ISTEP=%d", msg.majorStep.get(*data)),
+                entry("HB_MINOR_ISTEP=%d", msg.minorStep.get(*data)),
+                entry("REG_VAL=0x%08X", *data));
+        }
     }
+
+    errors.logSummary("collectSBEHBData");
 }
 
 REGISTER_PROCEDURE("collectSBEHBData", collectSBEHBData)
@@ -0,0 +1,93 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cfam_snapshot.hpp"
+#include "registration.hpp"
+#include "targeting.hpp"
+
+#include <stdlib.h>
+
+#include <phosphor-logging/log.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+
+namespace openpower
+{
+namespace debug
+{
+
+/**
+ * @brief Captures the CFAM registers of every processor to a snapshot
+ *        file, keeping the previous one, and logs how many registers
+ *        changed since it.  Use cfam-snapshot to see the changes.
+ * @return void
+ */
+void snapshotCFAM()
+{
+    using namespace openpower::cfam::snapshot;
+    using namespace openpower::targeting;
+    using namespace phosphor::logging;
+
+    auto env = getenv(registersEnv);
+    auto ranges = env ? loadRanges(env) : defaultRanges;
+
+    Targeting targets;
+    auto snapshot = capture(targets, ranges);
+
+    // Written aside first, so a failed save leaves the last
+    // snapshot where it was.
+    auto newPath = std::string{snapshotPath} + ".new";
+    save(snapshot, newPath);
+
+    std::error_code ec;
+    std::filesystem::rename(snapshotPath, previousSnapshotPath, ec);
+    bool havePrevious = !ec;
+
+    std::filesystem::rename(newPath, snapshotPath);
+
+    auto failed = std::count_if(
+        snapshot.entries.begin(), snapshot.entries.end(),
+        [](const auto& entry) { return entry.error != 0; });
+
+    log<level::INFO>("Captured CFAM snapshot", entry("PATH=%s", snapshotPath),
+                     entry("REGISTERS=%zu", snapshot.entries.size()),
+                     entry("FAILED=%zu", static_cast<size_t>(failed)));
+
+    if (!havePrevious)
+    {
+        return;
+    }
+
+    // The comparison is only a hint, so a bad old file isn't fatal
+    try
+    {
+        auto changes = diff(load(previousSnapshotPath), snapshot);
+        log<level::INFO>("CFAM registers changed since previous snapshot",
+                         entry("PATH=%s", previousSnapshotPath),
+                         entry("CHANGED=%zu", changes.size()));
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed comparing with previous CFAM snapshot",
+                        entry("ERROR=%s", e.what()));
+    }
+}
+
+REGISTER_PROCEDURE("snapshotCFAM", snapshotCFAM)
+
+} // namespace debug
+} // namespace openpower
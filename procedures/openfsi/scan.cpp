@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 #include "registration.hpp"
+#include "targeting.hpp"
 
 #include <org/open_power/Proc/FSI/error.hpp>
 #include <phosphor-logging/elog-errors.hpp>
@@ -74,6 +75,12 @@ void scan()
     // It is possible the driver will be updated in the future to actually
     // return a failure so the code will still check for them.
 
+    // The devices change, so the cached topology is stale.  It is done
+    // before in case the scan fails partway, and after so a topology
+    // another process finds during the scan isn't current either.
+    using openpower::targeting::Targeting;
+    Targeting::invalidateTopology();
+
     try
     {
         doScan(masterScanPath);
@@ -119,6 +126,8 @@ void scan()
         elog<fsi_error::SlaveDetectionFailure>(
             metadata::ERRNO(e.code().value()));
     }
+
+    Targeting::invalidateTopology();
 }
 
 REGISTER_PROCEDURE("scanFSI", scan)
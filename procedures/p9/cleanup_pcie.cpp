@@ -44,20 +44,18 @@ void cleanupPcie()
 
         log<level::INFO>("Running P9 procedure cleanupPcie");
 
-        // Disable the PCIE drivers and receiver on all CPUs
-        for (const auto& target : targets)
+        // Disable the PCIE drivers and receiver on all CPUs.
+        // We don't need an error log coming from the power off
+        // path, so failures just get one journal entry.
+        auto results = broadcastWrite(targets, P9_ROOT_CTRL1_CLEAR,
+                                      0x00001C00, Batch::Policy::bestEffort);
+
+        ErrorSummary errors;
+        for (const auto& [pos, result] : results)
         {
-            try
-            {
-                writeReg(target, P9_ROOT_CTRL1_CLEAR, 0x00001C00);
-            }
-            catch (const std::exception& e)
-            {
-                // Don't need an error log coming from the power off
-                // path, just keep trying on the other processors.
-                continue;
-            }
+            errors.check(result);
         }
+        errors.logSummary("cleanupPcie");
     }
     catch (const file_error::Open& e)
     {
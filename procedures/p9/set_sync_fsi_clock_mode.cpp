@@ -36,7 +36,8 @@ void setSynchronousFSIClock()
     const auto& master = *(targets.begin());
 
     // Set bit 31 to 0
-    writeRegWithMask(master, P9_LL_MODE_REG, 0x00000000, 0x00000001);
+    writeRegWithMask(master, P9_LL_MODE_REG,
+                     P9_LL_MODE_REG.asyncClockMode(0));
 }
 
 REGISTER_PROCEDURE("setSyncFSIClock", setSynchronousFSIClock)
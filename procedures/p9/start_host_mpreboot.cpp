@@ -49,25 +49,30 @@ void startHostMpReboot()
     log<level::INFO>("Running P9 procedure startHostMpReboot",
                      entry("NUM_PROCS=%d", targets.size()));
 
+    // All accesses go out together and stop at the first failure
+    Batch batch{Batch::Policy::stopOnError};
+
     // Ensure asynchronous clock mode is set
-    writeReg(master, P9_LL_MODE_REG, 0x00000001);
+    batch.write(master, P9_LL_MODE_REG,
+                P9_LL_MODE_REG.asyncClockMode.insert(0, 1));
 
     // Clock mux select override
     for (const auto& t : targets)
     {
-        writeRegWithMask(t, P9_ROOT_CTRL8, 0x0000000C, 0x0000000C);
+        batch.writeWithMask(t, P9_ROOT_CTRL8,
+                            P9_ROOT_CTRL8.clockMuxSelectOverride(0x3));
     }
 
     // Enable P9 checkstop to be reported to the BMC
 
     // Setup FSI2PIB to report checkstop
-    writeReg(master, P9_FSI_A_SI1S, 0x20000000);
+    batch.write(master, P9_FSI_A_SI1S, 0x20000000);
 
     // Enable Xstop/ATTN interrupt
-    writeReg(master, P9_FSI2PIB_TRUE_MASK, 0x60000000);
+    batch.write(master, P9_FSI2PIB_TRUE_MASK, 0x60000000);
 
     // Arm it
-    writeReg(master, P9_FSI2PIB_INTERRUPT, 0xFFFFFFFF);
+    batch.write(master, P9_FSI2PIB_INTERRUPT, 0xFFFFFFFF);
 
     // Kick off the SBE to start the boot
 
@@ -81,13 +86,17 @@ void startHostMpReboot()
     }
     else
     {
-        sbeSide = 0x00004000;
+        sbeSide = 1;
         log<level::INFO>("Setting SBE seeprom side to 1",
                          entry("SBE_SIDE_SELECT=%d", 1));
     }
     // Bit 17 of the ctrl status reg indicates sbe seeprom boot side
     // 0 -> Side 0, 1 -> Side 1
-    writeRegWithMask(master, P9_SBE_CTRL_STATUS, sbeSide, 0x00004000);
+    batch.writeWithMask(master, P9_SBE_CTRL_STATUS,
+                        P9_SBE_CTRL_STATUS.seepromSide(sbeSide));
+
+    batch.submit();
+    batch.check();
 
     // Call enter mpipl
     pdbg_targets_init(NULL);
@@ -3,11 +3,14 @@ extern "C"
 #include "libpdbg.h"
 }
 
+#include "cfam_access.hpp"
 #include "extensions/phal/common_utils.hpp"
 #include "extensions/phal/create_pel.hpp"
-#include "extensions/phal/pdbg_utils.hpp"
+#include "extensions/phal/pdbg_cfam_backend.hpp"
+#include "extensions/phal/proc_index.hpp"
 #include "p10_cfam.hpp"
 #include "registration.hpp"
+#include "targeting.hpp"
 
 #include <phosphor-logging/log.hpp>
 #include <sdbusplus/bus.hpp>
@@ -21,9 +24,22 @@ namespace openpower
 namespace phal
 {
 
+using namespace openpower::cfam::access;
 using namespace openpower::cfam::p10;
+using namespace openpower::targeting;
 using namespace phosphor::logging;
 
+/**
+ * Returns a Target that reaches the processor's CFAM through pdbg, at
+ * its FSI position so it shares arbitration and statistics with the
+ * sysfs Targets for the same chip
+ */
+static std::unique_ptr<Target> makeTarget(const Proc& proc)
+{
+    return std::make_unique<Target>(
+        proc.position, std::make_unique<PdbgCFAMBackend>(proc.target));
+}
+
 /** Best effort function to create a BMC dump */
 void createBmcDump()
 {
@@ -61,8 +77,6 @@ void createBmcDump()
  */
 void checkHostRunning()
 {
-    struct pdbg_target* procTarget;
-
     try
     {
         phal_init();
@@ -76,31 +90,33 @@ void checkHostRunning()
         throw std::runtime_error("PHAL initialization failed");
     }
 
-    pdbg_for_each_class_target("proc", procTarget)
+    for (const auto& proc : getProcs())
     {
         // Only check the primary proc
-        if (!isPrimaryProc(procTarget))
+        if (!proc.primary)
         {
             continue;
         }
 
-        uint32_t val = 0;
         constexpr uint32_t HOST_RUNNING_INDICATION = 0xA5000001;
-        auto rc = getCFAM(procTarget, P10_SCRATCH_REG_12, val);
-        if ((rc == 0) && (val != HOST_RUNNING_INDICATION))
+        auto target = makeTarget(proc);
+
+        auto val = tryReadReg(target, P10_SCRATCH_REG_12);
+
+        if (val && (*val != HOST_RUNNING_INDICATION))
         {
             log<level::INFO>("CFAM read indicates host is not running",
-                             entry("CFAM=0x%X", val));
+                             entry("CFAM=0x%X", *val));
             return;
         }
 
-        if (rc != 0)
+        if (!val)
         {
             // On error, we have to assume host is up so just fall through
             // to code below
             log<level::ERR>("CFAM read error, assume host is running");
         }
-        else if (val == HOST_RUNNING_INDICATION)
+        else
         {
             // This is not good. Normal communication path to host did not work
             // but CFAM indicates host is running.
@@ -141,7 +157,6 @@ void checkHostRunning()
  */
 void clearHostRunning()
 {
-    struct pdbg_target* procTarget;
     log<level::INFO>("Entering clearHostRunning");
 
     try
@@ -157,18 +172,19 @@ void clearHostRunning()
         throw std::runtime_error("PHAL initialization failed");
     }
 
-    pdbg_for_each_class_target("proc", procTarget)
+    for (const auto& proc : getProcs())
     {
         // Only check the primary proc
-        if (!isPrimaryProc(procTarget))
+        if (!proc.primary)
         {
             continue;
         }
 
         constexpr uint32_t HOST_NOT_RUNNING_INDICATION = 0;
-        auto rc = putCFAM(procTarget, P10_SCRATCH_REG_12,
-                          HOST_NOT_RUNNING_INDICATION);
-        if (rc != 0)
+        auto target = makeTarget(proc);
+
+        if (!tryWriteReg(target, P10_SCRATCH_REG_12,
+                         HOST_NOT_RUNNING_INDICATION))
         {
             log<level::ERR>("CFAM write to clear host running status failed");
         }
@@ -24,6 +24,7 @@ extern "C"
 
 #include "extensions/phal/create_pel.hpp"
 #include "extensions/phal/dump_utils.hpp"
+#include "extensions/phal/proc_index.hpp"
 
 #include <attributes_info.H>
 #include <libphal.H>
@@ -137,20 +138,14 @@ void sbeEnterMpReboot(struct pdbg_target* tgt)
 void enterMpReboot()
 {
     using namespace phosphor::logging;
-    struct pdbg_target* target;
     std::vector<pid_t> pidList;
     bool failed = false;
     pdbg_targets_init(NULL);
-    ATTR_HWAS_STATE_Type hwasState;
 
     log<level::INFO>("Starting memory preserving reboot");
-    pdbg_for_each_class_target("proc", target)
+    for (const auto& proc : openpower::phal::getProcs())
     {
-        if (DT_GET_PROP(ATTR_HWAS_STATE, target, hwasState))
-        {
-            log<level::ERR>("Could not read HWAS_STATE attribute");
-        }
-        if (!hwasState.functional)
+        if (!proc.functional)
         {
             continue;
         }
@@ -164,7 +159,7 @@ void enterMpReboot()
         }
         else if (pid == 0)
         {
-            sbeEnterMpReboot(target);
+            sbeEnterMpReboot(proc.target);
             std::exit(EXIT_SUCCESS);
         }
         else
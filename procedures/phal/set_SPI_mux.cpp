@@ -36,10 +36,14 @@ void setSPIMux()
 {
     Targeting targets;
 
+    // The host doesn't own the mux yet, so it's safe to shadow
     for (const auto& t : targets)
     {
-        writeRegWithMask(t, P10_ROOT_CTRL8, 0xF0000000, 0xF0000000);
+        t->setCacheable(P10_ROOT_CTRL8.address);
     }
+
+    broadcastWriteWithMask(targets, P10_ROOT_CTRL8,
+                           P10_ROOT_CTRL8.spiMuxSelect(0xF));
 }
 
 REGISTER_PROCEDURE("setSPIMux", setSPIMux)
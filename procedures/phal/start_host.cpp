@@ -8,6 +8,7 @@ extern "C"
 #include "extensions/phal/common_utils.hpp"
 #include "extensions/phal/create_pel.hpp"
 #include "extensions/phal/phal_error.hpp"
+#include "extensions/phal/proc_index.hpp"
 #include "util.hpp"
 
 #include <libekb.H>
@@ -35,13 +36,12 @@ using namespace phosphor::logging;
  */
 void selectBootSeeprom()
 {
-    struct pdbg_target* procTarget;
     ATTR_BACKUP_SEEPROM_SELECT_Enum bkpSeePromSelect;
     ATTR_BACKUP_MEASUREMENT_SEEPROM_SELECT_Enum bkpMeaSeePromSelect;
 
-    pdbg_for_each_class_target("proc", procTarget)
+    for (const auto& proc : getProcs())
     {
-        if (!isPrimaryProc(procTarget))
+        if (!proc.primary)
         {
             continue;
         }
@@ -68,7 +68,7 @@ void selectBootSeeprom()
         }
 
         // Set the Attribute as per bootcount policy for boot seeprom
-        if (DT_SET_PROP(ATTR_BACKUP_SEEPROM_SELECT, procTarget,
+        if (DT_SET_PROP(ATTR_BACKUP_SEEPROM_SELECT, proc.target,
                         bkpSeePromSelect))
         {
             log<level::ERR>(
@@ -78,7 +78,7 @@ void selectBootSeeprom()
         }
 
         // Set the Attribute as per bootcount policy for measurement seeprom
-        if (DT_SET_PROP(ATTR_BACKUP_MEASUREMENT_SEEPROM_SELECT, procTarget,
+        if (DT_SET_PROP(ATTR_BACKUP_MEASUREMENT_SEEPROM_SELECT, proc.target,
                         bkpMeaSeePromSelect))
         {
             log<level::ERR>(
@@ -155,10 +155,9 @@ void setClkNETerminationSite()
     }
 
     // update all the processor attributes
-    struct pdbg_target* procTarget;
-    pdbg_for_each_class_target("proc", procTarget)
+    for (const auto& proc : getProcs())
     {
-        if (DT_SET_PROP(ATTR_SYS_CLK_NE_TERMINATION_SITE, procTarget,
+        if (DT_SET_PROP(ATTR_SYS_CLK_NE_TERMINATION_SITE, proc.target,
                         clockTerm))
         {
             log<level::ERR>(
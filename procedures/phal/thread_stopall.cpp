@@ -1,5 +1,6 @@
 #include "extensions/phal/create_pel.hpp"
 #include "extensions/phal/dump_utils.hpp"
+#include "extensions/phal/proc_index.hpp"
 #include "registration.hpp"
 
 #include <attributes_info.H>
@@ -49,23 +50,15 @@ void threadStopAll(void)
             return;
         }
 
-        struct pdbg_target* procTarget;
-        ATTR_HWAS_STATE_Type hwasState;
-        pdbg_for_each_class_target("proc", procTarget)
+        for (const auto& proc : getProcs())
         {
-            if (DT_GET_PROP(ATTR_HWAS_STATE, procTarget, hwasState))
-            {
-                log<level::ERR>(
-                    std::format("({})Could not read HWAS_STATE attribute",
-                                pdbg_target_path(procTarget))
-                        .c_str());
-                continue;
-            }
-            if (!hwasState.functional)
+            if (!proc.functional)
             {
                 continue;
             }
 
+            auto procTarget = proc.target;
+
             try
             {
                 openpower::phal::sbe::threadStopProc(procTarget);
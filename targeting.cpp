@@ -16,15 +16,29 @@
 
 #include "targeting.hpp"
 
+#include "tracing.hpp"
+
 #include <endian.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
 
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/elog.hpp>
 #include <phosphor-logging/log.hpp>
 #include <xyz/openbmc_project/Common/File/error.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
 #include <filesystem>
-#include <regex>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
 
 namespace openpower
 {
@@ -34,51 +48,765 @@ namespace targeting
 using namespace phosphor::logging;
 namespace file_error = sdbusplus::xyz::openbmc_project::Common::File::Error;
 
+int Target::openCFAM()
+{
+    std::lock_guard<std::mutex> lock(backendMutex);
+
+    if (!opened)
+    {
+        auto err = backend->open();
+        if (err)
+        {
+            return err;
+        }
+
+        opened = true;
+    }
+
+    return 0;
+}
+
+openpower::cfam::backend::Backend& Target::getBackend()
+{
+    auto err = openCFAM();
+    if (err)
+    {
+        using metadata = xyz::openbmc_project::Common::File::Open;
+
+        elog<file_error::Open>(metadata::ERRNO(err),
+                               metadata::PATH(getCFAMPath().c_str()));
+    }
+
+    return *backend;
+}
+
 int Target::getCFAMFD()
 {
-    if (cfamFD.get() == nullptr)
+    return getBackend().getFD();
+}
+
+/**
+ * Bumped by invalidateAllCaches() to make every Target drop
+ * its cached register values.
+ */
+static std::atomic<uint64_t> globalCacheGeneration{0};
+
+void Target::checkCacheGeneration()
+{
+    auto generation = globalCacheGeneration.load();
+    if (generation != cacheGeneration)
     {
-        cfamFD =
-            std::make_unique<openpower::util::FileDescriptor>(getCFAMPath());
+        for (auto& [address, data] : cache)
+        {
+            data.reset();
+        }
+        cacheGeneration = generation;
     }
+}
 
-    return cfamFD->get();
+void Target::setCacheable(uint16_t address)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    cache.try_emplace(address, std::nullopt);
 }
 
-std::unique_ptr<Target>& Targeting::getTarget(size_t pos)
+bool Target::isCacheable(uint16_t address)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    return cache.contains(address);
+}
+
+std::optional<uint32_t> Target::getCachedReg(uint16_t address)
 {
-    auto search = [pos](const auto& t) { return t->getPos() == pos; };
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    checkCacheGeneration();
 
-    auto target = find_if(targets.begin(), targets.end(), search);
-    if (target == targets.end())
+    auto reg = cache.find(address);
+    if (reg == cache.end())
     {
-        throw std::runtime_error("Target not found: " + std::to_string(pos));
+        return std::nullopt;
     }
-    else
+
+    return reg->second;
+}
+
+void Target::updateCachedReg(uint16_t address, uint32_t data)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    checkCacheGeneration();
+
+    auto reg = cache.find(address);
+    if (reg != cache.end())
     {
-        return *target;
+        reg->second = data;
     }
 }
 
+void Target::invalidateCache()
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    for (auto& [address, data] : cache)
+    {
+        data.reset();
+    }
+}
+
+void Target::invalidateAllCaches()
+{
+    globalCacheGeneration++;
+}
+
+std::optional<ChipInfo> Target::getChipInfo()
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return chipInfo;
+}
+
+void Target::setChipInfo(const ChipInfo& info)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    chipInfo = info;
+}
+
+std::unique_ptr<Target>& Targeting::getTarget(size_t pos)
+{
+    if ((pos >= positions.size()) || (positions[pos] == noTarget))
+    {
+        throw std::runtime_error("Target not found: " + std::to_string(pos));
+    }
+
+    return targets[positions[pos]];
+}
+
+/**
+ * The highest position a slave name can have
+ */
+constexpr size_t maxSlavePosition = 99;
+
 Targeting::Targeting(const std::string& fsiMasterDev,
                      const std::string& fsiSlaveDir) :
     fsiMasterPath(fsiMasterDev), fsiSlaveBasePath(fsiSlaveDir)
 {
-    std::regex exp{"fsi1/slave@([0-9]{2}):00", std::regex::extended};
+    scan();
+}
+
+Targeting::Targeting(const std::string& fsiMasterDev,
+                     const std::string& fsiSlaveDir,
+                     const std::string& cfamDevDirectory) :
+    fsiMasterPath(fsiMasterDev), fsiSlaveBasePath(fsiSlaveDir),
+    cfamDevPath(cfamDevDirectory)
+{
+    scan();
+}
+
+Targeting::Targeting(const std::string& fsiMasterDev,
+                     const std::string& fsiSlaveDir,
+                     const std::string& cfamDevDirectory,
+                     const std::string& cacheFile) :
+    fsiMasterPath(fsiMasterDev), fsiSlaveBasePath(fsiSlaveDir),
+    cfamDevPath(cfamDevDirectory)
+{
+    scanCached(cacheFile);
+}
+
+Targeting::Targeting() :
+    fsiMasterPath(fsiMasterDevPath), fsiSlaveBasePath(fsiSlaveBaseDir)
+{
+    using namespace openpower::cfam::backend;
+
+    auto env = getenv(cfamBackendEnv);
+    std::string backend = env ? env : "";
+    if ((backend != "memory") && !backend.starts_with("memory:"))
+    {
+        if (backend != "sysfs")
+        {
+            cfamDevPath = cfamDevDir;
+        }
+
+        scanCached(topologyCachePath);
+    }
+    else
+    {
+        size_t count = 1;
+        auto colon = backend.find(':');
+        if (colon != std::string::npos)
+        {
+            auto first = backend.data() + colon + 1;
+            auto last = backend.data() + backend.size();
+            auto [end, ec] = std::from_chars(first, last, count);
+
+            // No more chips than there can be slaves
+            if ((ec != std::errc{}) || (end != last) || (count == 0) ||
+                (count > maxSlavePosition + 1))
+            {
+                log<level::ERR>("Invalid in-memory CFAM target count",
+                                entry("BACKEND=%s", backend.c_str()));
+                throw std::invalid_argument(
+                    std::string{"Invalid "} + cfamBackendEnv);
+            }
+        }
+
+        // Nothing for rescan() to look at
+        fsiMasterPath.clear();
+        fsiSlaveBasePath.clear();
+
+        log<level::INFO>("Using in-memory CFAM targets",
+                         entry("COUNT=%zu", count));
+
+        for (size_t pos = 0; pos < count; pos++)
+        {
+            targets.push_back(std::make_unique<Target>(
+                pos, std::make_unique<MemoryBackend>("memory" +
+                                                     std::to_string(pos))));
+        }
+
+        sort();
+    }
+
+    if (getenv(cfamPreopenEnv) != nullptr)
+    {
+        // The failures are logged, and come up again on first use
+        openAll();
+    }
+}
+
+Targeting::Targeting(std::vector<std::unique_ptr<Target>>&& newTargets) :
+    targets(std::move(newTargets))
+{
+    sort();
+}
+
+/**
+ * Returns the cfam character devices in a dir, by device number
+ */
+static std::map<dev_t, std::string> findCharDevs(const std::string& dir)
+{
+    std::map<dev_t, std::string> devices;
+
+    std::error_code ec;
+    for (auto& file : std::filesystem::directory_iterator(dir, ec))
+    {
+        struct stat st;
+        std::string path = file.path();
+
+        if (file.path().filename().string().starts_with("cfam") &&
+            (stat(path.c_str(), &st) == 0) && S_ISCHR(st.st_mode))
+        {
+            devices.emplace(st.st_rdev, path);
+        }
+    }
+
+    return devices;
+}
+
+/**
+ * Returns the character device of the FSI slave with a raw file,
+ * or the raw file if it has none
+ */
+static std::string preferCharDev(const std::string& rawPath,
+                                 const std::map<dev_t, std::string>& devices)
+{
+    if (devices.empty())
+    {
+        return rawPath;
+    }
+
+    // The slave's device number, as "major:minor"
+    auto devFile = std::filesystem::path{rawPath}.parent_path() / "dev";
+    std::ifstream file{devFile};
+
+    unsigned int major = 0;
+    unsigned int minor = 0;
+    char colon = 0;
+    if (!(file >> major >> colon >> minor) || (colon != ':'))
+    {
+        return rawPath;
+    }
+
+    auto device = devices.find(makedev(major, minor));
+    return (device != devices.end()) ? device->second : rawPath;
+}
+
+/**
+ * Returns the position in an FSI slave name like "slave@01:00",
+ * or nothing if it isn't one
+ */
+static std::optional<size_t> parseSlaveName(std::string_view name)
+{
+    constexpr std::string_view prefix = "slave@";
+    constexpr std::string_view suffix = ":00";
+
+    if ((name.size() != prefix.size() + 2 + suffix.size()) ||
+        !name.starts_with(prefix) || !name.ends_with(suffix))
+    {
+        return std::nullopt;
+    }
+
+    auto tens = name[prefix.size()];
+    auto ones = name[prefix.size() + 1];
+    if (!isdigit(tens) || !isdigit(ones))
+    {
+        return std::nullopt;
+    }
+
+    return (tens - '0') * 10 + (ones - '0');
+}
+
+/**
+ * Returns the contents of a small file, or nothing if it can't be read
+ */
+static std::optional<std::string> readFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return std::nullopt;
+    }
+
+    std::string contents;
+    char buffer[4096];
+    ssize_t rc = 0;
+    while ((rc = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        contents.append(buffer, rc);
+    }
+    close(fd);
+
+    if (rc < 0)
+    {
+        return std::nullopt;
+    }
+
+    return contents;
+}
+
+/**
+ * Returns the current FSI scan generation of a cache file
+ */
+static uint64_t getGeneration(const std::string& cacheFile)
+{
+    uint64_t generation = 0;
+
+    auto contents = readFile(cacheFile + ".generation");
+    if (contents)
+    {
+        std::from_chars(contents->data(), contents->data() + contents->size(),
+                        generation);
+    }
+
+    return generation;
+}
+
+/**
+ * The kernel's count of device events, which goes up with every
+ * device that is added, removed, bound or unbound
+ */
+constexpr auto ueventSeqnumPath = "/sys/kernel/uevent_seqnum";
+
+/**
+ * Returns what changes when the FSI devices may have, even if
+ * invalidateTopology() wasn't called, like when libipl, pdbg or
+ * hardware diagnostics rescan or unbind a link.  That is the kernel's
+ * device event count, and the modification time of the slave dir
+ * for filesystems that keep it, which sysfs doesn't always.
+ */
+static std::string getDeviceKey(const std::string& slaveDir)
+{
+    auto seqnum = readFile(ueventSeqnumPath).value_or("");
+    if (seqnum.ends_with('\n'))
+    {
+        seqnum.pop_back();
+    }
+
+    struct stat info
+    {};
+    stat(slaveDir.c_str(), &info);
+
+    return seqnum + " " + std::to_string(info.st_mtim.tv_sec) + "." +
+           std::to_string(info.st_mtim.tv_nsec);
+}
+
+/**
+ * Writes a file by renaming a temporary one over it, so readers never
+ * see part of it
+ *
+ * @return true on success
+ */
+static bool replaceFile(const std::string& path, const std::string& contents)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(
+        std::filesystem::path{path}.parent_path(), ec);
+
+    auto temp = path + "." + std::to_string(getpid());
+    {
+        std::ofstream file{temp, std::ios::trunc};
+        file << contents;
+        if (!file.flush())
+        {
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp, path, ec);
+    return !ec;
+}
+
+void Targeting::invalidateTopology(const std::string& cacheFile)
+{
+    // A process that scanned in the old generation can still save its
+    // topology after this, but it is tagged with the old generation.
+    auto generation = getGeneration(cacheFile) + 1;
+    if (!replaceFile(cacheFile + ".generation", std::to_string(generation)))
+    {
+        log<level::ERR>("Failed to invalidate the cached FSI topology",
+                        entry("PATH=%s", cacheFile.c_str()));
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(cacheFile, ec);
+}
+
+void ParallelResult::check() const
+{
+    for (const auto& outcome : outcomes)
+    {
+        if (outcome.error)
+        {
+            std::rethrow_exception(outcome.error);
+        }
+    }
+}
+
+ParallelResult Targeting::forEachParallel(const PerTarget& function,
+                                          Policy policy)
+{
+    ParallelResult result;
+    result.outcomes.resize(targets.size());
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> stop{false};
+
+    // Each worker takes the next target until there are none left
+    auto work = [&]() {
+        for (auto index = next++; index < targets.size(); index = next++)
+        {
+            auto& outcome = result.outcomes[index];
+            outcome.pos = targets[index]->getPos();
+
+            if (stop)
+            {
+                continue;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            try
+            {
+                function(targets[index]);
+            }
+            catch (...)
+            {
+                outcome.error = std::current_exception();
+                stop = (policy == Policy::stopOnError);
+            }
+
+            outcome.elapsed =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start);
+            outcome.ran = true;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    // This thread is one of the workers
+    std::vector<std::thread> threads;
+    auto workers = std::min(targets.size(), maxParallel);
+    for (size_t i = 1; i < workers; i++)
+    {
+        threads.emplace_back(work);
+    }
+
+    work();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    for (const auto& outcome : result.outcomes)
+    {
+        result.failed += outcome.error ? 1 : 0;
+        result.skipped += outcome.ran ? 0 : 1;
+    }
+
+    return result;
+}
+
+std::vector<OpenResult> Targeting::openAll()
+{
+    std::vector<OpenResult> results(targets.size());
+
+    // An open can wait on the FSI bus, so they are all done at
+    // once instead of one by one in the first accesses.
+    forEachParallel(
+        [this, &results](const std::unique_ptr<Target>& target) {
+            auto start = std::chrono::steady_clock::now();
+            auto err = target->openCFAM();
+            auto latency =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start);
+
+            results[positions[target->getPos()]] = {target->getPos(), err,
+                                                    latency};
+
+            OPENPOWER_PROBE(targeting__open__done, target->getPos(), err,
+                            latency.count());
+        },
+        Policy::bestEffort);
+
+    for (size_t index = 0; index < results.size(); index++)
+    {
+        if (results[index].error)
+        {
+            log<level::ERR>(
+                "Failed to open a CFAM",
+                entry("POSITION=%zu", results[index].pos),
+                entry("PATH=%s", targets[index]->getCFAMPath().c_str()),
+                entry("ERRNO=%d", results[index].error));
+        }
+    }
+
+    return results;
+}
+
+/**
+ * Returns the device and inode of a file, or nothing if it is gone
+ */
+static std::optional<std::pair<dev_t, ino_t>> getDevice(
+    const std::string& path)
+{
+    struct stat info
+    {};
+    if (stat(path.c_str(), &info) < 0)
+    {
+        return std::nullopt;
+    }
+
+    return std::make_pair(info.st_dev, info.st_ino);
+}
+
+std::vector<TargetChange> Targeting::rescan()
+{
+    std::vector<TargetChange> changes;
+    if (fsiMasterPath.empty())
+    {
+        return changes;
+    }
+
+    Targeting current{fsiMasterPath, fsiSlaveBasePath, cfamDevPath};
+    current.recordDevices();
+
+    for (auto& target : current.targets)
+    {
+        auto pos = target->getPos();
+        if ((pos >= positions.size()) || (positions[pos] == noTarget))
+        {
+            changes.push_back({pos, TargetChange::Type::added});
+            continue;
+        }
+
+        // A device that was recreated has the same path, but not the
+        // same inode.  Ones that couldn't be looked at are trusted.
+        auto& old = targets[positions[pos]];
+        auto known = devices.find(pos);
+        auto device = current.devices.find(pos);
+        if ((old->getCFAMPath() != target->getCFAMPath()) ||
+            ((known != devices.end()) && (device != current.devices.end()) &&
+             (known->second != device->second)))
+        {
+            changes.push_back({pos, TargetChange::Type::replaced});
+            old.reset();
+            continue;
+        }
+
+        target = std::move(old);
+    }
+
+    // The ones that are left
+    for (const auto& target : targets)
+    {
+        if (target)
+        {
+            changes.push_back(
+                {target->getPos(), TargetChange::Type::removed});
+        }
+    }
+
+    targets = std::move(current.targets);
+    devices = std::move(current.devices);
+    sort();
+
+    if (!changes.empty())
+    {
+        log<level::INFO>("The FSI targets changed",
+                         entry("CHANGES=%zu", changes.size()),
+                         entry("TARGETS=%zu", targets.size()));
+
+        // A copy, so subscribers can unsubscribe from the call
+        auto notify = subscribers;
+        for (const auto& [id, subscriber] : notify)
+        {
+            subscriber(changes);
+        }
+    }
+
+    return changes;
+}
+
+size_t Targeting::subscribe(Subscriber&& subscriber)
+{
+    subscribers.emplace(nextSubscriber, std::move(subscriber));
+    return nextSubscriber++;
+}
+
+void Targeting::unsubscribe(size_t id)
+{
+    subscribers.erase(id);
+}
+
+void Targeting::scanCached(const std::string& cacheFile)
+{
+    // From before the scan, so a scan that races an invalidation
+    // or a device change doesn't look current
+    auto generation = getGeneration(cacheFile);
+    auto deviceKey = getDeviceKey(fsiSlaveBasePath);
+
+    if (!loadTopology(cacheFile, generation, deviceKey))
+    {
+        scan();
+        saveTopology(cacheFile, generation, deviceKey);
+    }
+}
+
+bool Targeting::loadTopology(const std::string& cacheFile,
+                             uint64_t generation,
+                             const std::string& deviceKey)
+{
+    // Read with as few syscalls as possible, as it is done every time
+    auto contents = readFile(cacheFile);
+    if (!contents)
+    {
+        return false;
+    }
+
+    std::string_view rest{*contents};
+    auto nextLine = [&rest]() {
+        auto end = rest.find('\n');
+        auto line = rest.substr(0, end);
+        rest.remove_prefix((end == std::string_view::npos) ? rest.size()
+                                                           : end + 1);
+        return line;
+    };
+
+    if ((nextLine() != std::to_string(generation)) ||
+        (nextLine() != deviceKey) || (nextLine() != fsiMasterPath) ||
+        (nextLine() != fsiSlaveBasePath) || (nextLine() != cfamDevPath))
+    {
+        return false;
+    }
+
+    std::vector<std::pair<size_t, std::string>> topology;
+    while (!rest.empty())
+    {
+        auto line = nextLine();
+
+        size_t pos = 0;
+        auto [end, ec] = std::from_chars(line.data(),
+                                         line.data() + line.size(), pos);
+        // Slave names only have two digits, and a bad position
+        // would make a huge position table.
+        if ((ec != std::errc{}) || (end == line.data() + line.size()) ||
+            (*end != ' ') || (pos > maxSlavePosition))
+        {
+            return false;
+        }
+
+        // The paths aren't checked, as that would cost as much as
+        // the scan.  The generation and device key catch changes.
+        topology.emplace_back(pos,
+                              std::string{end + 1, line.data() + line.size()});
+    }
+
+    if (topology.empty())
+    {
+        return false;
+    }
+
+    for (auto& [pos, path] : topology)
+    {
+        targets.push_back(std::make_unique<Target>(pos, path));
+    }
+
+    sort();
+
+    OPENPOWER_PROBE(targeting__load__done, targets.size());
+
+    return true;
+}
+
+void Targeting::saveTopology(const std::string& cacheFile,
+                             uint64_t generation,
+                             const std::string& deviceKey)
+{
+    std::string contents = std::to_string(generation) + "\n" + deviceKey +
+                           "\n" + fsiMasterPath + "\n" + fsiSlaveBasePath +
+                           "\n" + cfamDevPath + "\n";
+
+    for (const auto& target : targets)
+    {
+        contents += std::to_string(target->getPos()) + " " +
+                    target->getCFAMPath() + "\n";
+    }
+
+    // Only a cache, so the next process scans if this fails
+    replaceFile(cacheFile, contents);
+}
+
+void Targeting::scan()
+{
+    OPENPOWER_PROBE(targeting__scan__start);
+
+    // The kernel's per-chip character devices have the same offsets
+    // as the raw files, and skip sysfs on every access.
+    std::map<dev_t, std::string> devices;
+    if (!cfamDevPath.empty())
+    {
+        devices = findCharDevs(cfamDevPath);
+    }
 
     // Always create P0, the FSI master.
-    targets.push_back(std::make_unique<Target>(0, fsiMasterPath));
+    targets.push_back(
+        std::make_unique<Target>(0, preferCharDev(fsiMasterPath, devices)));
     try
     {
         // Find the the remaining P9s dynamically based on which files show up
         for (auto& file : std::filesystem::directory_iterator(fsiSlaveBasePath))
         {
-            std::smatch match;
             std::string path = file.path();
-            if (std::regex_search(path, match, exp))
+            auto pos = parseSlaveName(file.path().filename().native());
+            if (pos)
             {
-                auto pos = atoi(match[1].str().c_str());
-                if (pos == 0)
+                if (*pos == 0)
                 {
                     log<level::ERR>("Unexpected FSI slave device name found",
                                     entry("DEVICE_NAME=%s", path.c_str()));
@@ -87,7 +815,8 @@ Targeting::Targeting(const std::string& fsiMasterDev,
 
                 path += "/raw";
 
-                targets.push_back(std::make_unique<Target>(pos, path));
+                targets.push_back(std::make_unique<Target>(
+                    *pos, preferCharDev(path, devices)));
             }
         }
     }
@@ -99,11 +828,45 @@ Targeting::Targeting(const std::string& fsiMasterDev,
                                metadata::PATH(e.path1().c_str()));
     }
 
+    sort();
+
+    OPENPOWER_PROBE(targeting__scan__done, targets.size());
+}
+
+void Targeting::recordDevices()
+{
+    devices.clear();
+
+    for (const auto& target : targets)
+    {
+        auto device = getDevice(target->getCFAMPath());
+        if (device)
+        {
+            devices.emplace(target->getPos(), *device);
+        }
+    }
+}
+
+void Targeting::sort()
+{
     auto sortTargets = [](const std::unique_ptr<Target>& left,
                           const std::unique_ptr<Target>& right) {
         return left->getPos() < right->getPos();
     };
     std::sort(targets.begin(), targets.end(), sortTargets);
+
+    // Positions are small, so a table beats a search for
+    // the lookups done for every access in a procedure.
+    positions.clear();
+    if (!targets.empty())
+    {
+        positions.resize(targets.back()->getPos() + 1, noTarget);
+    }
+
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        positions[targets[i]->getPos()] = i;
+    }
 }
 
 } // namespace targeting
@@ -1,8 +1,18 @@
 #pragma once
 
-#include "filedescriptor.hpp"
+#include "cfam_backend.hpp"
+#include "cfam_stats.hpp"
 
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 
 namespace openpower
@@ -14,6 +24,62 @@ constexpr auto fsiMasterDevPath = "/sys/class/fsi-master/fsi0/slave@00:00/raw";
 
 constexpr auto fsiSlaveBaseDir = "/sys/class/fsi-master/fsi1/";
 
+/**
+ * Where newer kernels put the /dev/cfamN character devices
+ */
+constexpr auto cfamDevDir = "/dev";
+
+/**
+ * Where the default Targeting saves the topology it scanned, so the
+ * next process doesn't have to scan sysfs again.  The FSI scan
+ * generation, which invalidateTopology() bumps, is in the same path
+ * with ".generation" appended.  The cache is also scanned again after
+ * the kernel reports any device change.
+ */
+constexpr auto topologyCachePath = "/run/openpower-proc-control/topology";
+
+/**
+ * Setting this environment variable to "memory" or "memory:<count>"
+ * makes the default Targeting use in-memory stand-in chips instead
+ * of the FSI hardware, and "sysfs" makes it use the sysfs raw files
+ * even where there are character devices.
+ */
+constexpr auto cfamBackendEnv = "OPENPOWER_CFAM_BACKEND";
+
+/**
+ * Setting this environment variable makes the default Targeting open
+ * every target's CFAM device at once, instead of each one on its first
+ * access.  See Targeting::openAll().
+ */
+constexpr auto cfamPreopenEnv = "OPENPOWER_CFAM_PREOPEN";
+
+/**
+ * The identity of a chip, from its chip ID register
+ */
+struct ChipInfo
+{
+    /**
+     * The raw chip ID register
+     */
+    uint32_t chipId = 0;
+
+    /**
+     * The chip type, like 0xD1 for a P9 Nimbus
+     */
+    uint8_t type = 0;
+
+    /**
+     * The EC level, with the major level in the high nibble,
+     * like 0x22 for DD2.2
+     */
+    uint8_t ec = 0;
+
+    /**
+     * If it is the FSI master, which is at position 0
+     */
+    bool master = false;
+};
+
 /**
  * Represents a specific P9 processor in the system.  Used by
  * the access APIs to specify the chip to operate on.
@@ -28,14 +94,30 @@ class Target
      * @param[in] - The sysfs device path
      */
     Target(size_t position, const std::string& devPath) :
-        pos(position), cfamPath(devPath)
+        Target(position,
+               std::make_unique<openpower::cfam::backend::SysfsBackend>(
+                   devPath))
+    {}
+
+    /**
+     * Constructor
+     *
+     * @param[in] - The logical position of the target
+     * @param[in] - The backend used to reach the CFAM
+     */
+    Target(size_t position,
+           std::unique_ptr<openpower::cfam::backend::Backend>&& cfamBackend) :
+        pos(position), cfamPath(cfamBackend->getPath()),
+        backend(std::move(cfamBackend)),
+        stats(openpower::cfam::stats::getStats(position, cfamPath))
     {}
 
     Target() = delete;
     ~Target() = default;
-    Target(const Target&) = default;
-    Target(Target&&) = default;
-    Target& operator=(Target&&) = default;
+    Target(const Target&) = delete;
+    Target& operator=(const Target&) = delete;
+    Target(Target&&) = delete;
+    Target& operator=(Target&&) = delete;
 
     /**
      * Returns the position
@@ -46,7 +128,8 @@ class Target
     }
 
     /**
-     * Returns the CFAM sysfs path
+     * Returns the CFAM sysfs path, or what the
+     * backend uses in its place
      */
     inline auto getCFAMPath() const
     {
@@ -55,11 +138,116 @@ class Target
 
     /**
      * Returns the file descriptor to use
-     * for read/writeCFAM operations.
+     * for read/writeCFAM operations, or -1
+     * if the backend doesn't use one.
+     *
+     * Safe to call from multiple threads; the device
+     * is only opened once.
      */
     int getCFAMFD();
 
+    /**
+     * Returns the backend used to reach the CFAM,
+     * after opening it if needed.
+     *
+     * Throws an exception if it can't be opened.
+     */
+    openpower::cfam::backend::Backend& getBackend();
+
+    /**
+     * Returns true if the backend accesses the CFAM through
+     * getCFAMFD(), so transfers can be vectored or asynchronous.
+     */
+    inline bool hasFD() const
+    {
+        return backend->hasFD();
+    }
+
+    /**
+     * Opens the CFAM backend if it isn't already, without
+     * throwing on failure.
+     *
+     * @return 0 on success, else the errno from the open
+     */
+    int openCFAM();
+
+    /**
+     * Returns the access statistics of the chip, which
+     * are shared with other Targets for it.
+     */
+    inline openpower::cfam::stats::AccessStats& getStats()
+    {
+        return *stats;
+    }
+
+    /**
+     * Marks a register as cacheable, which opts it in to the
+     * shadow cache.  Only use this for registers whose value
+     * doesn't change behind our back, as a masked write that
+     * wouldn't change the cached value will be skipped.
+     *
+     * Registers are volatile, and never cached, by default.
+     *
+     * @param[in] address - The CFAM register address
+     */
+    void setCacheable(uint16_t address);
+
+    /**
+     * Returns true if the register was marked cacheable
+     *
+     * @param[in] address - The CFAM register address
+     */
+    bool isCacheable(uint16_t address);
+
+    /**
+     * Returns the last known value of a cacheable register,
+     * if there is one.
+     *
+     * @param[in] address - The CFAM register address
+     */
+    std::optional<uint32_t> getCachedReg(uint16_t address);
+
+    /**
+     * Records the value just read from or written to a register.
+     * Does nothing if the register isn't cacheable.
+     *
+     * @param[in] address - The CFAM register address
+     * @param[in] data - The register value
+     */
+    void updateCachedReg(uint16_t address, uint32_t data);
+
+    /**
+     * Forgets all cached register values for this target
+     */
+    void invalidateCache();
+
+    /**
+     * Forgets all cached register values for every target in
+     * the process, such as after a CFAM reset.
+     */
+    static void invalidateAllCaches();
+
+    /**
+     * Returns the chip identity, if setChipInfo() stored it.
+     * It isn't dropped with the register cache, as a CFAM
+     * reset doesn't change the chip.
+     */
+    std::optional<ChipInfo> getChipInfo();
+
+    /**
+     * Stores the chip identity, once it was read
+     *
+     * @param[in] info - The chip identity
+     */
+    void setChipInfo(const ChipInfo& info);
+
   private:
+    /**
+     * Drops the cached values if invalidateAllCaches() was called
+     * since they were stored.  Must hold cacheMutex.
+     */
+    void checkCacheGeneration();
+
     /**
      * The logical position of this target
      */
@@ -71,9 +259,151 @@ class Target
     const std::string cfamPath;
 
     /**
-     * The file descriptor to use for read/writeCFAMReg
+     * The backend to use for read/writeCFAMReg
+     */
+    std::unique_ptr<openpower::cfam::backend::Backend> backend;
+
+    /**
+     * If the backend was opened
+     */
+    bool opened = false;
+
+    /**
+     * Serializes the lazy open of the backend
+     */
+    std::mutex backendMutex;
+
+    /**
+     * The access statistics
+     */
+    std::shared_ptr<openpower::cfam::stats::AccessStats> stats;
+
+    /**
+     * The shadow register cache.  The keys are the cacheable
+     * registers and the values their last known contents.
+     */
+    std::map<uint16_t, std::optional<uint32_t>> cache;
+
+    /**
+     * The invalidateAllCaches() generation the cache is from
+     */
+    uint64_t cacheGeneration = 0;
+
+    /**
+     * The chip identity, once it was read
+     */
+    std::optional<ChipInfo> chipInfo;
+
+    /**
+     * Serializes access to the shadow register cache and chipInfo
+     */
+    std::mutex cacheMutex;
+};
+
+/**
+ * The outcome of opening a target's CFAM in Targeting::openAll()
+ */
+struct OpenResult
+{
+    /**
+     * The position of the target
+     */
+    size_t pos;
+
+    /**
+     * 0, or the errno of the failure
+     */
+    int error;
+
+    /**
+     * How long the open took
+     */
+    std::chrono::nanoseconds latency;
+};
+
+/**
+ * The outcome of Targeting::forEachParallel()
+ */
+struct ParallelResult
+{
+    /**
+     * The outcome on one target
+     */
+    struct Outcome
+    {
+        /**
+         * The position of the target
+         */
+        size_t pos = 0;
+
+        /**
+         * False if it was skipped after another target failed
+         */
+        bool ran = false;
+
+        /**
+         * What the function threw, if anything
+         */
+        std::exception_ptr error;
+
+        /**
+         * How long the function took
+         */
+        std::chrono::nanoseconds elapsed{0};
+    };
+
+    /**
+     * The outcome on each target, in position order
+     */
+    std::vector<Outcome> outcomes;
+
+    /**
+     * The number of targets whose function threw
+     */
+    size_t failed = 0;
+
+    /**
+     * The number of targets that were skipped
      */
-    std::unique_ptr<openpower::util::FileDescriptor> cfamFD;
+    size_t skipped = 0;
+
+    /**
+     * How long all of them took
+     */
+    std::chrono::nanoseconds elapsed{0};
+
+    /**
+     * Rethrows the failure of the lowest position, if there was one
+     */
+    void check() const;
+};
+
+/**
+ * A change to the targets found by Targeting::rescan()
+ */
+struct TargetChange
+{
+    enum class Type
+    {
+        /**
+         * A chip appeared
+         */
+        added,
+
+        /**
+         * A chip went away
+         */
+        removed,
+
+        /**
+         * The chip's device was recreated, such as by a CFAM reset,
+         * so it has a new Target
+         */
+        replaced
+    };
+
+    size_t pos;
+    Type type;
 };
 
 /**
@@ -90,7 +420,44 @@ class Targeting
      */
     Targeting(const std::string& fsiMasterDev, const std::string& fsiSlaveDir);
 
-    Targeting() : Targeting(fsiMasterDevPath, fsiSlaveBaseDir) {}
+    /**
+     * Scans sysfs the same way, but uses a processor's /dev/cfamN
+     * character device in place of its raw file if it has one.
+     * @param[in] fsiMasterDev - the sysfs device for the master
+     * @param[in] fsiSlaveDirectory - the base sysfs dir for slaves
+     * @param[in] cfamDevDirectory - the dir of the character devices
+     */
+    Targeting(const std::string& fsiMasterDev, const std::string& fsiSlaveDir,
+              const std::string& cfamDevDirectory);
+
+    /**
+     * Uses the topology saved in a cache file if it is from the current
+     * FSI scan generation, and otherwise scans like the constructor
+     * above and saves what it found.
+     * @param[in] fsiMasterDev - the sysfs device for the master
+     * @param[in] fsiSlaveDirectory - the base sysfs dir for slaves
+     * @param[in] cfamDevDirectory - the dir of the character devices
+     * @param[in] cacheFile - the topology cache file
+     */
+    Targeting(const std::string& fsiMasterDev, const std::string& fsiSlaveDir,
+              const std::string& cfamDevDirectory,
+              const std::string& cacheFile);
+
+    /**
+     * Uses the system's FSI devices, preferring the character devices,
+     * unless cfamBackendEnv asks for in-memory stand-ins or sysfs.
+     * The topology is cached in topologyCachePath, and the devices
+     * are opened right away if cfamPreopenEnv is set.
+     */
+    Targeting();
+
+    /**
+     * Uses targets that were already created, such
+     * as ones with a non-sysfs backend.
+     *
+     * @param[in] newTargets - The targets
+     */
+    explicit Targeting(std::vector<std::unique_ptr<Target>>&& newTargets);
 
     ~Targeting() = default;
     Targeting(const Targeting&) = default;
@@ -122,11 +489,152 @@ class Targeting
     }
 
     /**
-     * Returns a target by position.
+     * Returns a target by position, without a search.
+     *
+     * Throws an exception if there isn't one.
      */
     std::unique_ptr<Target>& getTarget(size_t pos);
 
+    /**
+     * @brief Starts a new FSI scan generation, so the cached topology
+     *        is scanned again.  For after the FSI devices change, like
+     *        from an FSI scan or a CFAM reset.
+     *
+     * @param[in] cacheFile - the topology cache file
+     */
+    static void invalidateTopology(
+        const std::string& cacheFile = topologyCachePath);
+
+    /**
+     * What forEachParallel() does when a target fails
+     */
+    enum class Policy
+    {
+        bestEffort, // Run the rest anyway
+        stopOnError // Skip the ones that haven't started
+    };
+
+    /**
+     * The work forEachParallel() does on each target
+     */
+    using PerTarget = std::function<void(const std::unique_ptr<Target>&)>;
+
+    /**
+     * The most threads forEachParallel() uses
+     */
+    static constexpr size_t maxParallel = 8;
+
+    /**
+     * @brief Calls a function for every target, on up to maxParallel
+     *        threads, including this one.
+     *
+     * For work that blocks on each chip in turn, like waiting for a
+     * register, so the chips wait at the same time.  Register accesses
+     * on their own are better queued in a Batch.  The function must not
+     * share a Batch between targets, or change the targets.
+     *
+     * Doesn't throw what the function throws; that is captured per
+     * target, and ParallelResult::check() rethrows it.
+     *
+     * @param[in] function - Called with each target
+     * @param[in] policy - What to do if a target fails
+     * @return - The outcome on each target and overall
+     */
+    ParallelResult forEachParallel(const PerTarget& function,
+                                   Policy policy = Policy::bestEffort);
+
+    /**
+     * @brief Opens every target's CFAM that isn't already open, all at
+     *        the same time.
+     *
+     * The targets keep them open, so this takes the opens out of the
+     * first accesses.  Doesn't throw; the failures are logged and
+     * returned, and those targets try again on their next access.
+     *
+     * @return - The outcome on each target, in position order
+     */
+    std::vector<OpenResult> openAll();
+
+    /**
+     * Called with the changes from a rescan()
+     */
+    using Subscriber = std::function<void(const std::vector<TargetChange>&)>;
+
+    /**
+     * @brief Scans sysfs again and updates the targets to match.
+     *
+     * Targets whose device didn't change are kept, along with their
+     * open device and register cache.  The others are created again,
+     * and references to them, like from getTarget(), are no longer
+     * valid.  Subscribers are called if anything changed.
+     *
+     * A device recreated at the same path is only seen if
+     * recordDevices() or an earlier rescan() saw the old one.
+     * Does nothing for targets that weren't found in sysfs.
+     *
+     * @return - The changes
+     */
+    std::vector<TargetChange> rescan();
+
+    /**
+     * @brief Remembers the device and inode of each target's device,
+     *        so rescan() can tell if it is recreated.
+     *
+     * It stats every device, so it is left to the processes that
+     * rescan, like when a Watch starts, instead of being done for
+     * every Targeting.
+     */
+    void recordDevices();
+
+    /**
+     * @brief Calls a function with the changes whenever rescan()
+     *        finds some.
+     *
+     * @param[in] subscriber - The function
+     * @return - The ID to unsubscribe with
+     */
+    size_t subscribe(Subscriber&& subscriber);
+
+    /**
+     * Stops calling a function subscribe() added
+     *
+     * @param[in] id - The ID subscribe() returned
+     */
+    void unsubscribe(size_t id);
+
   private:
+    /**
+     * Creates the targets for the sysfs devices that exist
+     */
+    void scan();
+
+    /**
+     * Loads the targets from a cache file, or scans for them and
+     * saves them to it
+     */
+    void scanCached(const std::string& cacheFile);
+
+    /**
+     * Creates the targets from a cache file, if it was saved in the
+     * generation with the same device key and paths.
+     *
+     * @return true if it was used
+     */
+    bool loadTopology(const std::string& cacheFile, uint64_t generation,
+                      const std::string& deviceKey);
+
+    /**
+     * Saves the targets to a cache file, tagged with the generation
+     * and device key that were current before they were scanned.
+     */
+    void saveTopology(const std::string& cacheFile, uint64_t generation,
+                      const std::string& deviceKey);
+
+    /**
+     * Sorts the targets by position and indexes them
+     */
+    void sort();
+
     /**
      * The path to the fsi-master sysfs device to access
      */
@@ -137,10 +645,40 @@ class Targeting
      */
     std::string fsiSlaveBasePath;
 
+    /**
+     * The dir of the character devices, or empty to not use them
+     */
+    std::string cfamDevPath;
+
     /**
      * A container of Targets in the system
      */
     std::vector<std::unique_ptr<Target>> targets;
+
+    /**
+     * The index in targets of each position, or noTarget
+     * for the positions without one
+     */
+    std::vector<size_t> positions;
+
+    static constexpr size_t noTarget = SIZE_MAX;
+
+    /**
+     * The device and inode of each target's device when
+     * recordDevices() or rescan() last saw it, which change if the
+     * kernel recreates it
+     */
+    std::map<size_t, std::pair<dev_t, ino_t>> devices;
+
+    /**
+     * The functions to call with the changes from rescan()
+     */
+    std::map<size_t, Subscriber> subscribers;
+
+    /**
+     * The ID for the next subscriber
+     */
+    size_t nextSubscriber = 0;
 };
 
 } // namespace targeting
@@ -0,0 +1,204 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "targeting_watch.hpp"
+
+#include <linux/netlink.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <phosphor-logging/log.hpp>
+
+#include <cerrno>
+#include <filesystem>
+#include <string_view>
+
+namespace openpower
+{
+namespace targeting
+{
+
+using namespace phosphor::logging;
+
+/**
+ * The kernel's uevent multicast group
+ */
+constexpr uint32_t kernelGroup = 1;
+
+/**
+ * Opens the kernel uevent socket, or returns -1
+ */
+static int openUevents()
+{
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                    NETLINK_KOBJECT_UEVENT);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = kernelGroup;
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * Watches a dir for files renamed into it or written, or returns -1
+ */
+static int watchDir(const std::filesystem::path& dir)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    if (inotify_add_watch(fd, dir.c_str(), IN_MOVED_TO | IN_CLOSE_WRITE) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+Watch::Watch(Targeting& targets, const std::string& cacheFile) :
+    targets(targets),
+    generationName(
+        std::filesystem::path{cacheFile + ".generation"}.filename()),
+    ueventFD(openUevents()),
+    inotifyFD(watchDir(std::filesystem::path{cacheFile}.parent_path())),
+    epollFD(epoll_create1(EPOLL_CLOEXEC))
+{
+    // So the first rescan can tell which devices were recreated
+    targets.recordDevices();
+
+    if (ueventFD.get() < 0)
+    {
+        // Still told about this BMC's scans and resets
+        log<level::ERR>("Failed to listen for FSI uevents",
+                        entry("ERRNO=%d", errno));
+    }
+
+    for (auto fd : {ueventFD.get(), inotifyFD.get()})
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+
+        if ((fd >= 0) && (epollFD.get() >= 0))
+        {
+            epoll_ctl(epollFD.get(), EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+}
+
+bool Watch::readUevents()
+{
+    bool fsi = false;
+    char buffer[8192];
+
+    while (ueventFD.get() >= 0)
+    {
+        auto size = recv(ueventFD.get(), buffer, sizeof(buffer), 0);
+        if (size <= 0)
+        {
+            break;
+        }
+
+        // Like "add@/devices/...", then NUL separated KEY=value pairs
+        std::string_view message{buffer, static_cast<size_t>(size)};
+        while (!message.empty() && !fsi)
+        {
+            auto end = message.find('\0');
+            auto field = message.substr(0, end);
+            message.remove_prefix(
+                (end == std::string_view::npos) ? message.size() : end + 1);
+
+            fsi = field.starts_with("SUBSYSTEM=fsi") ||
+                  field.starts_with("DEVNAME=cfam");
+        }
+    }
+
+    return fsi;
+}
+
+bool Watch::readGeneration()
+{
+    bool changed = false;
+    alignas(inotify_event) char buffer[4096];
+
+    while (inotifyFD.get() >= 0)
+    {
+        auto size = read(inotifyFD.get(), buffer, sizeof(buffer));
+        if (size <= 0)
+        {
+            break;
+        }
+
+        for (auto next = buffer; next < buffer + size;)
+        {
+            auto event = reinterpret_cast<inotify_event*>(next);
+            if ((event->len > 0) && (generationName == event->name))
+            {
+                changed = true;
+            }
+
+            next += sizeof(inotify_event) + event->len;
+        }
+    }
+
+    return changed;
+}
+
+std::vector<TargetChange> Watch::process()
+{
+    // Drains both, as one rescan covers a burst of events
+    bool uevents = readUevents();
+    bool generation = readGeneration();
+
+    if (!uevents && !generation)
+    {
+        return {};
+    }
+
+    try
+    {
+        return targets.rescan();
+    }
+    catch (const std::exception& e)
+    {
+        log<level::INFO>("Failed to rescan the FSI targets",
+                         entry("ERROR=%s", e.what()));
+    }
+
+    return {};
+}
+
+} // namespace targeting
+} // namespace openpower
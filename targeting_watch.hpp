@@ -0,0 +1,111 @@
+#pragma once
+
+#include "filedescriptor.hpp"
+#include "targeting.hpp"
+
+#include <string>
+#include <vector>
+
+namespace openpower
+{
+namespace targeting
+{
+
+/**
+ * @class Watch
+ *
+ * Keeps a Targeting up to date for a long running process, so it can
+ * keep its targets, and their open devices and caches, across FSI
+ * scans and CFAM resets instead of creating new ones.
+ *
+ * It listens for the kernel's FSI uevents, and for the topology
+ * generation that Targeting::invalidateTopology() bumps, on a single
+ * descriptor for the process's event loop.  When that is readable,
+ * process() calls Targeting::rescan(), which tells its subscribers
+ * what changed.
+ */
+class Watch
+{
+  public:
+    Watch() = delete;
+    ~Watch() = default;
+    Watch(const Watch&) = delete;
+    Watch& operator=(const Watch&) = delete;
+    Watch(Watch&&) = delete;
+    Watch& operator=(Watch&&) = delete;
+
+    /**
+     * @brief Starts watching.
+     *
+     * @param[in] targets - The targets to keep up to date
+     * @param[in] cacheFile - The topology cache file, whose
+     *                        generation is watched
+     */
+    explicit Watch(Targeting& targets,
+                   const std::string& cacheFile = topologyCachePath);
+
+    /**
+     * Returns the descriptor that is readable when there are
+     * events for process()
+     */
+    inline int getFD() const
+    {
+        return epollFD.get();
+    }
+
+    /**
+     * @brief Reads the pending events, and rescans if any could
+     *        have changed the targets.
+     *
+     * Doesn't block.  If the scan fails, like while a CFAM reset
+     * has the slaves unbound, the targets are left as they were
+     * until the next event.
+     *
+     * @return - The changes
+     */
+    std::vector<TargetChange> process();
+
+  private:
+    /**
+     * Reads the pending uevents
+     *
+     * @return true if any were for FSI devices
+     */
+    bool readUevents();
+
+    /**
+     * Reads the pending inotify events
+     *
+     * @return true if the topology generation changed
+     */
+    bool readGeneration();
+
+    /**
+     * The targets to keep up to date
+     */
+    Targeting& targets;
+
+    /**
+     * The name of the topology generation file
+     */
+    std::string generationName;
+
+    /**
+     * The kernel uevent socket, or -1 if it couldn't be opened
+     */
+    util::FileDescriptor ueventFD;
+
+    /**
+     * The inotify descriptor for the generation file's dir,
+     * or -1 if it couldn't be watched
+     */
+    util::FileDescriptor inotifyFD;
+
+    /**
+     * Polls the other two
+     */
+    util::FileDescriptor epollFD;
+};
+
+} // namespace targeting
+} // namespace openpower
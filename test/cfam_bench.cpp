@@ -0,0 +1,323 @@
+/**
+ * Copyright (C) 2026 IBM Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cfam_access.hpp"
+#include "cfam_backend.hpp"
+#include "targeting.hpp"
+
+#include <getopt.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Microbenchmarks of the CFAM access layer, run against a simulated
+ * FSI sysfs tree of plain files in a temporary directory.
+ */
+
+using namespace openpower::cfam::access;
+using namespace openpower::cfam::backend;
+using namespace openpower::targeting;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+
+/**
+ * The size of a simulated raw file, which covers every driver offset
+ */
+constexpr auto rawFileSize = 0x40000;
+
+/**
+ * The register the access benchmarks use
+ */
+constexpr cfam_address_t benchReg = 0x2818;
+
+struct Options
+{
+    size_t sockets = 4;
+    size_t iterations = 20000;
+    std::chrono::microseconds latency{0};
+};
+
+/**
+ * A sysfs backend that spins for a fixed time before every access,
+ * to stand in for the FSI bus.
+ */
+class LatencyBackend : public SysfsBackend
+{
+  public:
+    LatencyBackend(const std::string& path,
+                   std::chrono::microseconds latency) :
+        SysfsBackend(path), latency(latency)
+    {}
+
+    int read(uint16_t address, uint16_t offset, uint32_t& data) override
+    {
+        wait();
+        return SysfsBackend::read(address, offset, data);
+    }
+
+    int write(uint16_t address, uint16_t offset, uint32_t data) override
+    {
+        wait();
+        return SysfsBackend::write(address, offset, data);
+    }
+
+  private:
+    void wait() const
+    {
+        // Sleeping would add the scheduler's slack to every access
+        auto end = Clock::now() + latency;
+        while (Clock::now() < end)
+        {}
+    }
+
+    std::chrono::microseconds latency;
+};
+
+/**
+ * A simulated sysfs tree with a master and sockets - 1 slaves
+ */
+class SysfsTree
+{
+  public:
+    explicit SysfsTree(size_t sockets)
+    {
+        std::string dir =
+            (std::filesystem::temp_directory_path() / "cfam_benchXXXXXX");
+        if (mkdtemp(dir.data()) == nullptr)
+        {
+            throw std::runtime_error("Could not create a temp directory");
+        }
+
+        base = dir;
+        slaveDir = base / "fsi1";
+        std::filesystem::create_directory(slaveDir);
+
+        masterPath = base / "raw";
+        createRaw(masterPath);
+
+        for (size_t pos = 1; pos < sockets; pos++)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "slave@%02zu:00", pos);
+
+            auto slave = slaveDir / name;
+            std::filesystem::create_directory(slave);
+            createRaw(slave / "raw");
+        }
+    }
+
+    ~SysfsTree()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(base, ec);
+    }
+
+    SysfsTree(const SysfsTree&) = delete;
+    SysfsTree& operator=(const SysfsTree&) = delete;
+
+    /**
+     * Returns the raw file path for a position
+     */
+    std::string rawPath(size_t pos) const
+    {
+        if (pos == 0)
+        {
+            return masterPath;
+        }
+
+        char name[32];
+        snprintf(name, sizeof(name), "slave@%02zu:00", pos);
+        return slaveDir / name / "raw";
+    }
+
+    std::filesystem::path base;
+    std::filesystem::path slaveDir;
+    std::filesystem::path masterPath;
+
+  private:
+    static void createRaw(const std::filesystem::path& path)
+    {
+        std::ofstream(path).close();
+        std::filesystem::resize_file(path, rawFileSize);
+    }
+};
+
+/**
+ * Returns the read and write syscalls the process has made so far
+ */
+uint64_t syscallCount()
+{
+    std::ifstream io{"/proc/self/io"};
+    std::string key;
+    uint64_t value = 0;
+    uint64_t count = 0;
+
+    while (io >> key >> value)
+    {
+        if ((key == "syscr:") || (key == "syscw:"))
+        {
+            count += value;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Runs an operation and prints its throughput, latency percentiles
+ * and syscalls per operation.
+ */
+void run(const std::string& name, size_t iterations,
+         const std::function<void(size_t)>& op)
+{
+    std::vector<double> latencies;
+    latencies.reserve(iterations);
+
+    // Warm up, which also opens the devices
+    op(0);
+
+    auto syscalls = syscallCount();
+    auto start = Clock::now();
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+        auto opStart = Clock::now();
+        op(i);
+        latencies.push_back(
+            std::chrono::duration<double, std::micro>(Clock::now() - opStart)
+                .count());
+    }
+
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start);
+    syscalls = syscallCount() - syscalls;
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+
+    printf("%-24s %10.0f %9.2f %9.2f %9.2f %9.2f %9.2f\n", name.c_str(),
+           iterations / elapsed.count(), percentile(0.50), percentile(0.90),
+           percentile(0.99), latencies.back(),
+           static_cast<double>(syscalls) / iterations);
+}
+
+void usage(char** argv)
+{
+    std::cerr << "Usage: " << argv[0]
+              << " [--sockets N] [--iterations N] [--latency-us N]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    const struct option longOptions[] = {
+        {"sockets", required_argument, nullptr, 's'},
+        {"iterations", required_argument, nullptr, 'i'},
+        {"latency-us", required_argument, nullptr, 'l'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+
+    int opt = 0;
+    while ((opt = getopt_long(argc, argv, "s:i:l:h", longOptions, nullptr)) !=
+           -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                options.sockets = std::max(1, atoi(optarg));
+                break;
+            case 'i':
+                options.iterations = std::max(1, atoi(optarg));
+                break;
+            case 'l':
+                options.latency = std::chrono::microseconds(atoi(optarg));
+                break;
+            default:
+                usage(argv);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    SysfsTree tree{options.sockets};
+
+    std::vector<std::unique_ptr<Target>> targetList;
+    for (size_t pos = 0; pos < options.sockets; pos++)
+    {
+        targetList.push_back(std::make_unique<Target>(
+            pos,
+            std::make_unique<LatencyBackend>(tree.rawPath(pos),
+                                             options.latency)));
+    }
+    Targeting targets{std::move(targetList)};
+
+    auto target = [&targets, &options](size_t i) -> auto& {
+        return targets.getTarget(i % options.sockets);
+    };
+
+    printf("sockets %zu, iterations %zu, latency %lldus\n\n", options.sockets,
+           options.iterations,
+           static_cast<long long>(options.latency.count()));
+    printf("%-24s %10s %9s %9s %9s %9s %9s\n", "benchmark", "ops/s",
+           "p50(us)", "p90(us)", "p99(us)", "max(us)", "sys/op");
+
+    run("readReg", options.iterations,
+        [&](size_t i) { readReg(target(i), benchReg); });
+
+    run("writeReg", options.iterations,
+        [&](size_t i) { writeReg(target(i), benchReg, i); });
+
+    run("writeRegWithMask", options.iterations, [&](size_t i) {
+        writeRegWithMask(target(i), benchReg, i, 0x0000FFFF);
+    });
+
+    run("writeRegWithMask cached", options.iterations, [&](size_t i) {
+        target(i)->setCacheable(benchReg);
+        writeRegWithMask(target(i), benchReg, i, 0x0000FFFF);
+    });
+
+    // A whole 16 register block, which is one vectored read
+    run("readRange 16", options.iterations,
+        [&](size_t i) { readRange(target(i), 0x1000, 16); });
+
+    // Discovery is much slower than an access
+    run("Targeting", std::max<size_t>(options.iterations / 100, 1),
+        [&](size_t) {
+            Targeting discovered{tree.masterPath, tree.slaveDir};
+        });
+
+    // What later processes do until the FSI devices change
+    auto cache = (tree.base / "topology").string();
+    run("Targeting cached", std::max<size_t>(options.iterations / 100, 1),
+        [&](size_t) {
+            Targeting discovered{tree.masterPath, tree.slaveDir, "", cache};
+        });
+
+    return 0;
+}
@@ -13,13 +13,28 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include "cfam_access.hpp"
+#include "cfam_arbitration.hpp"
+#include "cfam_retry.hpp"
+#include "cfam_snapshot.hpp"
+#include "p9_cfam.hpp"
+#include "p9_chip.hpp"
 #include "registration.hpp"
 #include "targeting.hpp"
+#include "targeting_watch.hpp"
 
+#include <fcntl.h>
+#include <poll.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
 
+#include <atomic>
 #include <filesystem>
 #include <fstream>
+#include <sstream>
+#include <thread>
 
 #include <gtest/gtest.h>
 
@@ -108,6 +123,1015 @@ TEST_F(TargetingTest, CreateTargets)
     }
 }
 
+TEST_F(TargetingTest, CharDevs)
+{
+    using namespace openpower::cfam::access;
+
+    // Stands in for /dev/cfam1, with the device number of /dev/zero
+    auto devDir = _slaveBaseDir / "dev";
+    std::filesystem::create_directory(devDir);
+    if (mknod((devDir / "cfam1").c_str(), S_IFCHR | 0600, makedev(1, 5)))
+    {
+        GTEST_SKIP() << "Can't make character devices";
+    }
+
+    std::filesystem::create_directory(_slaveDir / "slave@01:00");
+    std::filesystem::create_directory(_slaveDir / "slave@02:00");
+    std::ofstream(_slaveDir / "slave@01:00" / "dev") << "1:5\n";
+    std::ofstream(_slaveDir / "slave@02:00" / "dev") << "1:9\n";
+
+    Targeting targets{masterDir, _slaveDir, devDir};
+    ASSERT_EQ(targets.size(), 3);
+
+    // Only the slave with a character device uses it
+    EXPECT_EQ(targets.getTarget(0)->getCFAMPath(), masterDir);
+    EXPECT_EQ(targets.getTarget(1)->getCFAMPath(), devDir / "cfam1");
+    EXPECT_EQ(targets.getTarget(2)->getCFAMPath(),
+              _slaveDir / "slave@02:00/raw");
+    EXPECT_EQ(readReg(targets.getTarget(1), 0x1000), 0);
+
+    // Without the dir it is all sysfs
+    Targeting sysfs{masterDir, _slaveDir};
+    EXPECT_EQ(sysfs.getTarget(1)->getCFAMPath(),
+              _slaveDir / "slave@01:00/raw");
+
+    std::filesystem::remove_all(devDir);
+}
+
+TEST_F(TargetingTest, TopologyCache)
+{
+    auto addSlave = [this](const std::string& name) {
+        std::filesystem::create_directory(_slaveDir / name);
+        std::ofstream(_slaveDir / name / "raw");
+    };
+
+    addSlave("slave@01:00");
+    addSlave("slave@02:00");
+
+    // Not slaves
+    addSlave("slave@1:00");
+    addSlave("slave@0a:00");
+    addSlave("slave@03:00.old");
+
+    auto cache = (_slaveBaseDir / "topology").string();
+    {
+        Targeting targets{masterDir, _slaveDir, "", cache};
+        ASSERT_EQ(targets.size(), 3);
+        EXPECT_EQ(targets.getTarget(2)->getCFAMPath(),
+                  _slaveDir / "slave@02:00/raw");
+    }
+
+    // Like sysfs, which doesn't always update the dir's time, the
+    // cache doesn't see the new chip until a new generation
+    auto mtime = std::filesystem::last_write_time(_slaveDir);
+    addSlave("slave@04:00");
+    std::filesystem::last_write_time(_slaveDir, mtime);
+    {
+        Targeting targets{masterDir, _slaveDir, "", cache};
+        EXPECT_EQ(targets.size(), 3);
+    }
+
+    Targeting::invalidateTopology(cache);
+    {
+        Targeting targets{masterDir, _slaveDir, "", cache};
+        ASSERT_EQ(targets.size(), 4);
+        EXPECT_EQ(targets.getTarget(4)->getCFAMPath(),
+                  _slaveDir / "slave@04:00/raw");
+    }
+
+    // Until then
+    mtime = std::filesystem::last_write_time(_slaveDir);
+    std::filesystem::remove_all(_slaveDir / "slave@04:00");
+    std::filesystem::last_write_time(_slaveDir, mtime);
+    {
+        Targeting targets{masterDir, _slaveDir, "", cache};
+        EXPECT_EQ(targets.size(), 4);
+    }
+
+    // A slave dir that changed since the save makes it scan again
+    addSlave("slave@05:00");
+    {
+        Targeting targets{masterDir, _slaveDir, "", cache};
+        ASSERT_EQ(targets.size(), 4);
+        EXPECT_EQ(targets.getTarget(5)->getCFAMPath(),
+                  _slaveDir / "slave@05:00/raw");
+        EXPECT_THROW(targets.getTarget(4), std::runtime_error);
+    }
+
+    // Other paths are a different topology
+    mtime = std::filesystem::last_write_time(_slaveDir);
+    std::filesystem::remove_all(_slaveDir / "slave@05:00");
+    std::filesystem::last_write_time(_slaveDir, mtime);
+    {
+        Targeting targets{masterDir, _slaveDir, "/dev", cache};
+        EXPECT_EQ(targets.size(), 3);
+    }
+}
+
+TEST_F(TargetingTest, OpenAll)
+{
+    std::filesystem::create_directory(_slaveDir / "slave@01:00");
+    std::filesystem::create_directory(_slaveDir / "slave@02:00");
+    std::filesystem::create_directory(_slaveDir / "slave@03:00");
+    std::ofstream(_slaveDir / "slave@01:00/raw");
+    std::ofstream(_slaveDir / "slave@02:00/raw");
+
+    // The master is a dir, and slave 3 has no raw file
+    Targeting targets{masterDir, _slaveDir};
+    auto results = targets.openAll();
+    ASSERT_EQ(results.size(), 4);
+
+    for (size_t pos = 0; pos < results.size(); pos++)
+    {
+        EXPECT_EQ(results[pos].pos, pos);
+    }
+    EXPECT_EQ(results[0].error, EISDIR);
+    EXPECT_EQ(results[1].error, 0);
+    EXPECT_EQ(results[2].error, 0);
+    EXPECT_EQ(results[3].error, ENOENT);
+    EXPECT_GT(results[1].latency.count(), 0);
+
+    auto fd = targets.getTarget(1)->getCFAMFD();
+    EXPECT_GE(fd, 0);
+
+    // The open ones stay open
+    std::ofstream(_slaveDir / "slave@03:00/raw");
+    results = targets.openAll();
+    EXPECT_EQ(results[3].error, 0);
+    EXPECT_EQ(targets.getTarget(1)->getCFAMFD(), fd);
+}
+
+TEST_F(TargetingTest, Rescan)
+{
+    std::filesystem::create_directory(_slaveDir / "slave@01:00");
+    std::ofstream(_slaveDir / "slave@01:00/raw");
+
+    // A recreated device is seen once the devices are recorded
+    Targeting targets{masterDir, _slaveDir};
+    targets.recordDevices();
+    auto* first = targets.getTarget(1).get();
+    std::filesystem::rename(_slaveDir / "slave@01:00/raw",
+                            _slaveDir / "slave@01:00/old");
+    std::ofstream(_slaveDir / "slave@01:00/raw");
+
+    auto changes = targets.rescan();
+    ASSERT_EQ(changes.size(), 1);
+    EXPECT_EQ(changes[0].type,
+              openpower::targeting::TargetChange::Type::replaced);
+    EXPECT_NE(targets.getTarget(1).get(), first);
+}
+
+TEST_F(TargetingTest, Watch)
+{
+    using Type = openpower::targeting::TargetChange::Type;
+
+    auto addSlave = [this](const std::string& name) {
+        std::filesystem::create_directory(_slaveDir / name);
+        std::ofstream(_slaveDir / name / "raw");
+    };
+
+    addSlave("slave@01:00");
+    addSlave("slave@02:00");
+
+    Targeting targets{masterDir, _slaveDir};
+    auto cache = (_slaveBaseDir / "topology").string();
+    openpower::targeting::Watch watch{targets, cache};
+    ASSERT_GE(watch.getFD(), 0);
+
+    std::vector<openpower::targeting::TargetChange> seen;
+    targets.subscribe([&seen](const auto& changes) { seen = changes; });
+
+    auto* second = targets.getTarget(2).get();
+    targets.getTarget(1)->setCacheable(0x1000);
+
+    // A new chip, one that went away, and one whose device was
+    // recreated, which has a new inode
+    addSlave("slave@03:00");
+    std::filesystem::remove_all(_slaveDir / "slave@01:00");
+    std::filesystem::rename(_slaveDir / "slave@02:00/raw",
+                            _slaveDir / "slave@02:00/old");
+    std::ofstream(_slaveDir / "slave@02:00/raw");
+    Targeting::invalidateTopology(cache);
+
+    pollfd ready{watch.getFD(), POLLIN, 0};
+    ASSERT_EQ(poll(&ready, 1, 1000), 1);
+
+    auto changes = watch.process();
+    ASSERT_EQ(changes.size(), 3);
+    EXPECT_EQ(seen.size(), 3);
+    EXPECT_EQ(targets.size(), 3);
+    EXPECT_THROW(targets.getTarget(1), std::runtime_error);
+    EXPECT_NE(targets.getTarget(2).get(), second);
+    EXPECT_EQ(targets.getTarget(3)->getCFAMPath(),
+              _slaveDir / "slave@03:00/raw");
+
+    for (const auto& change : changes)
+    {
+        auto expected = (change.pos == 1)   ? Type::removed
+                        : (change.pos == 2) ? Type::replaced
+                                            : Type::added;
+        EXPECT_EQ(change.type, expected);
+    }
+
+    // Unchanged chips keep their Target, and a chip that comes
+    // back starts over
+    auto* third = targets.getTarget(3).get();
+    addSlave("slave@01:00");
+    EXPECT_EQ(targets.rescan().size(), 1);
+    EXPECT_EQ(targets.getTarget(3).get(), third);
+    EXPECT_FALSE(targets.getTarget(1)->isCacheable(0x1000));
+}
+
+class CFAMAccessTest : public TargetingTest
+{
+  protected:
+    virtual void SetUp()
+    {
+        TargetingTest::SetUp();
+
+        // A regular file stands in for the master's raw CFAM device
+        _cfamPath = _slaveBaseDir / "raw";
+        std::ofstream(_cfamPath).close();
+        std::filesystem::resize_file(_cfamPath, 0x4000);
+    }
+
+    std::filesystem::path _cfamPath;
+};
+
+TEST_F(CFAMAccessTest, Batch)
+{
+    using namespace openpower::cfam::access;
+
+    Targeting targets{_cfamPath, _slaveDir};
+    const auto& master = *(targets.begin());
+
+    writeReg(master, 0x2810, 0x11111111);
+
+    Batch batch;
+    auto w1 = batch.write(master, 0x2800, 0x12345678);
+    auto w2 = batch.write(master, 0x2801, 0x9ABCDEF0);
+    auto m = batch.writeWithMask(master, 0x2810, 0x22222222, 0x0000FFFF);
+    auto r1 = batch.read(master, 0x2800);
+    auto r2 = batch.read(master, 0x2801);
+    batch.submit();
+
+    ASSERT_FALSE(batch.hasFailure());
+    EXPECT_EQ(batch.result(w1).error, 0);
+    EXPECT_EQ(batch.result(w2).error, 0);
+    EXPECT_EQ(batch.result(m).data, 0x11112222);
+    EXPECT_EQ(batch.result(r1).data, 0x12345678);
+    EXPECT_EQ(batch.result(r2).data, 0x9ABCDEF0);
+    EXPECT_EQ(readReg(master, 0x2810), 0x11112222);
+    EXPECT_NO_THROW(batch.check());
+}
+
+TEST_F(CFAMAccessTest, ShadowCache)
+{
+    using namespace openpower::cfam::access;
+
+    Targeting targets{_cfamPath, _slaveDir};
+    const auto& master = *(targets.begin());
+
+    writeReg(master, 0x2818, 0x000000FF);
+
+    master->setCacheable(0x2818);
+    EXPECT_FALSE(master->getCachedReg(0x2818));
+
+    // The first masked write has to read the register
+    writeRegWithMask(master, 0x2818, 0xF0000000, 0xF0000000);
+    ASSERT_EQ(master->getCachedReg(0x2818), 0xF00000FF);
+
+    // Leave a stale value in the cache to prove it's used for reads
+    writeReg(master, 0x2818, 0x0);
+    master->updateCachedReg(0x2818, 0xF00000FF);
+    EXPECT_EQ(readReg(master, 0x2818), 0xF00000FF);
+
+    Target::invalidateAllCaches();
+    EXPECT_FALSE(master->getCachedReg(0x2818));
+    EXPECT_EQ(readReg(master, 0x2818), 0x0);
+
+    // Volatile registers are never cached
+    readReg(master, 0x2819);
+    EXPECT_FALSE(master->getCachedReg(0x2819));
+}
+
+TEST_F(CFAMAccessTest, BatchFanOut)
+{
+    using namespace openpower::cfam::access;
+
+    // Two working slaves and one whose device can't be opened
+    for (auto slave : {"slave@01:00", "slave@02:00", "slave@03:00"})
+    {
+        std::filesystem::create_directory(_slaveDir / slave);
+    }
+    for (auto slave : {"slave@01:00", "slave@02:00"})
+    {
+        auto raw = _slaveDir / slave / "raw";
+        std::ofstream(raw).close();
+        std::filesystem::resize_file(raw, 0x4000);
+    }
+
+    Targeting targets{_cfamPath, _slaveDir};
+    ASSERT_EQ(targets.size(), 4);
+
+    Batch batch;
+    std::vector<size_t> ids;
+    for (const auto& t : targets)
+    {
+        ids.push_back(batch.writeWithMask(t, 0x2918, 0xC, 0xC));
+    }
+    batch.submit();
+
+    EXPECT_TRUE(batch.hasFailure());
+    EXPECT_EQ(batch.result(ids[0]).data, 0xC);
+    EXPECT_EQ(batch.result(ids[1]).data, 0xC);
+    EXPECT_EQ(batch.result(ids[2]).data, 0xC);
+    EXPECT_EQ(batch.result(ids[3]).error, ENOENT);
+
+    EXPECT_EQ(readReg(targets.getTarget(2), 0x2918), 0xC);
+}
+
+TEST_F(CFAMAccessTest, Broadcast)
+{
+    using namespace openpower::cfam::access;
+
+    // One working slave and one whose device can't be opened
+    for (auto slave : {"slave@01:00", "slave@02:00"})
+    {
+        std::filesystem::create_directory(_slaveDir / slave);
+    }
+    auto raw = _slaveDir / "slave@01:00" / "raw";
+    std::ofstream(raw).close();
+    std::filesystem::resize_file(raw, 0x4000);
+
+    Targeting targets{_cfamPath, _slaveDir};
+    ASSERT_EQ(targets.size(), 3);
+
+    // Nothing is written unless every target can be reached
+    EXPECT_THROW(broadcastWriteWithMask(targets, 0x2918, 0x3, 0x3),
+                 std::exception);
+    EXPECT_EQ(readReg(targets.getTarget(0), 0x2918), 0);
+
+    auto results = broadcastWriteWithMask(targets, 0x2918, 0x3, 0x3,
+                                          Batch::Policy::bestEffort);
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_EQ(results.at(0).value(), 0x3);
+    EXPECT_EQ(results.at(1).value(), 0x3);
+    ASSERT_FALSE(results.at(2));
+    EXPECT_EQ(results.at(2).error().error, ENOENT);
+
+    EXPECT_EQ(readReg(targets.getTarget(1), 0x2918), 0x3);
+}
+
+TEST_F(CFAMAccessTest, Range)
+{
+    using namespace openpower::cfam::access;
+
+    auto target = std::make_unique<Target>(0, _cfamPath);
+
+    // Crosses from the 0x1000 block into the 0x1400 block
+    std::vector<cfam_data_t> data{0x11, 0x22, 0x33, 0x44, 0x55};
+    writeRange(target, 0x13FD, data);
+
+    EXPECT_EQ(readReg(target, 0x13FF), 0x33);
+    EXPECT_EQ(readReg(target, 0x1400), 0x44);
+    EXPECT_EQ(readRange(target, 0x13FD, data.size()), data);
+
+    // Queued as one read per register
+    auto reads = target->getStats().getCount(
+        openpower::cfam::recorder::Type::read);
+    Batch batch;
+    auto first = batch.readRange(target, 0x13FD, data.size());
+    batch.submit();
+    EXPECT_EQ(batch.result(first + 4).data, 0x55);
+    EXPECT_EQ(target->getStats().getCount(
+                  openpower::cfam::recorder::Type::read),
+              reads + data.size());
+
+    EXPECT_THROW(readRange(target, 0xFFFF, 2), std::exception);
+}
+
+TEST_F(CFAMAccessTest, TryAccess)
+{
+    using namespace openpower::cfam::access;
+
+    auto good = std::make_unique<Target>(0, _cfamPath);
+    auto missing = std::make_unique<Target>(1, _slaveDir / "none");
+
+    EXPECT_EQ(tryWriteReg(good, 0x1000, 0x1234), 0x1234);
+    EXPECT_EQ(tryWriteRegWithMask(good, 0x1000, 0xFF00, 0xF000), 0xF234);
+    EXPECT_EQ(tryReadReg(good, 0x1000), 0xF234);
+
+    auto result = tryReadReg(missing, 0x1000);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error().step, AccessError::Step::open);
+    EXPECT_EQ(result.error().error, ENOENT);
+    EXPECT_EQ(result.error().target, 1);
+
+    auto now = std::chrono::steady_clock::now();
+    auto wait = tryWaitForReg(missing, 0x1000, 0xFF, 0, now);
+    ASSERT_FALSE(wait);
+    EXPECT_EQ(wait.error().step, AccessError::Step::open);
+    EXPECT_THROW(waitForReg(missing, 0x1000, 0xFF, 0, now), std::exception);
+    EXPECT_TRUE(tryWaitForReg(good, 0x1000, 0xFF, 0x34, now)->matched);
+
+    Batch batch;
+    auto id = batch.read(missing, 0x1000);
+    batch.submit();
+
+    ErrorSummary errors;
+    EXPECT_TRUE(errors.check(tryReadReg(good, 0x1000)));
+    EXPECT_FALSE(errors.check(result));
+    EXPECT_FALSE(errors.check(batch.value(id)));
+    EXPECT_EQ(errors.get().size(), 2);
+    errors.logSummary("TryAccess");
+}
+
+TEST_F(CFAMAccessTest, Stats)
+{
+    using namespace openpower::cfam::access;
+    using namespace openpower::cfam::stats;
+    using namespace openpower::cfam::arbitration;
+
+    auto saved = getPriority();
+    setPriority(Priority::normal);
+
+    auto target = std::make_unique<Target>(0, _cfamPath);
+    auto missing = std::make_unique<Target>(1, _slaveDir / "none");
+
+    writeReg(target, 0x1000, 1);
+    readReg(target, 0x1000);
+    readReg(target, 0x1001);
+    EXPECT_FALSE(tryReadReg(missing, 0x1000));
+
+    // Shared with other Targets for the same chip
+    auto again = std::make_unique<Target>(0, _cfamPath);
+    writeRegWithMask(again, 0x1000, 0, 1);
+
+    auto& stats = target->getStats();
+    EXPECT_EQ(stats.getCount(Type::read), 2);
+    EXPECT_EQ(stats.getCount(Type::write), 1);
+    EXPECT_EQ(stats.getCount(Type::writeWithMask), 1);
+    EXPECT_EQ(stats.getErrors(Type::read), 0);
+
+    uint64_t bucketed = 0;
+    for (size_t b = 0; b < AccessStats::latencyBuckets; b++)
+    {
+        bucketed += stats.getLatencyCount(Type::read, b);
+    }
+    EXPECT_EQ(bucketed, 2);
+
+    EXPECT_EQ(missing->getStats().getErrors(Type::read), 1);
+    EXPECT_EQ(missing->getStats().getErrnoCount(ENOENT), 1);
+    EXPECT_EQ(stats.getLockCount(), 4);
+    setPriority(saved);
+
+    EXPECT_EQ(AccessStats::toBucket(std::chrono::nanoseconds(0)), 0);
+    EXPECT_EQ(AccessStats::toBucket(std::chrono::nanoseconds(1000)), 10);
+    EXPECT_EQ(AccessStats::toBucket(std::chrono::hours(1)),
+              AccessStats::latencyBuckets - 1);
+
+    std::ostringstream dump;
+    dumpAll(dump);
+    EXPECT_NE(dump.str().find("errno 2: 1"), std::string::npos);
+}
+
+TEST(CFAMArbitrationTest, Priority)
+{
+    using namespace openpower::cfam::arbitration;
+    using namespace std::chrono_literals;
+
+    // Creates the lock file.  A second open file description of it
+    // then stands in for another process.
+    Lock{0, Priority::normal};
+    int fd = open(lockPath, O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        GTEST_SKIP() << "No lock file";
+    }
+
+    auto setLock = [fd](short type, off_t start) {
+        struct flock lock
+        {};
+        lock.l_type = type;
+        lock.l_whence = SEEK_SET;
+        lock.l_start = start;
+        lock.l_len = 1;
+        return fcntl(fd, F_OFD_SETLK, &lock);
+    };
+
+    // An unlikely chip position, with a waiting critical process
+    constexpr size_t pos = 1000;
+    ASSERT_EQ(setLock(F_WRLCK, pos * 4), 0);
+    ASSERT_EQ(setLock(F_RDLCK, pos * 4 + 1), 0);
+
+    std::atomic<bool> locked = false;
+    std::thread background{[&locked]() {
+        Lock lock{pos, Priority::background};
+        locked = true;
+        EXPECT_GE(lock.getWait(), 40ms);
+    }};
+
+    // Stays out of the way of the critical process
+    std::this_thread::sleep_for(20ms);
+    setLock(F_UNLCK, pos * 4);
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(locked);
+
+    setLock(F_UNLCK, pos * 4 + 1);
+    background.join();
+    EXPECT_TRUE(locked);
+
+    close(fd);
+}
+
+TEST(CFAMArbitrationTest, WaitForReg)
+{
+    using namespace openpower::cfam::access;
+    using namespace openpower::cfam::arbitration;
+    using namespace openpower::cfam::backend;
+    using namespace std::chrono_literals;
+
+    Lock{0, Priority::normal};
+    int fd = open(lockPath, O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        GTEST_SKIP() << "No lock file";
+    }
+
+    // Another process has the chip
+    constexpr size_t pos = 1001;
+    struct flock lock
+    {};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = pos * 4;
+    lock.l_len = 1;
+    ASSERT_EQ(fcntl(fd, F_OFD_SETLK, &lock), 0);
+
+    auto target = std::make_unique<Target>(
+        pos, std::make_unique<MemoryBackend>("memory"));
+
+    // Arbitration is only on when a priority is set
+    auto saved = getPriority();
+    setPriority(Priority::normal);
+
+    std::atomic<bool> done = false;
+    WaitResult result;
+    std::thread poller{[&]() {
+        result = waitForReg(target, 0x1000, 0xFF, 0,
+                            std::chrono::steady_clock::now() + 5s);
+        done = true;
+    }};
+
+    // The poll waits for it
+    std::this_thread::sleep_for(30ms);
+    EXPECT_FALSE(done);
+
+    lock.l_type = F_UNLCK;
+    fcntl(fd, F_OFD_SETLK, &lock);
+    poller.join();
+
+    EXPECT_TRUE(result.matched);
+    EXPECT_GE(result.elapsed, 30ms);
+
+    // A nested lock on the chip doesn't deadlock the thread
+    {
+        auto outer = acquire(pos);
+        ASSERT_TRUE(outer);
+        EXPECT_EQ(readReg(target, 0x1000), 0);
+    }
+
+    setPriority(std::nullopt);
+    EXPECT_FALSE(acquire(pos));
+    setPriority(saved);
+
+    close(fd);
+}
+
+TEST(CFAMBackendTest, Memory)
+{
+    using namespace openpower::cfam::access;
+    using namespace openpower::cfam::backend;
+
+    for (auto bad : {"memory:0", "memory:101", "memory:2x", "memory:"})
+    {
+        setenv(cfamBackendEnv, bad, 1);
+        EXPECT_THROW(Targeting{}, std::invalid_argument) << bad;
+    }
+
+    setenv(cfamBackendEnv, "memory:3", 1);
+    Targeting targets;
+    unsetenv(cfamBackendEnv);
+
+    ASSERT_EQ(targets.size(), 3);
+    EXPECT_EQ(targets.getTarget(2)->getCFAMPath(), "memory2");
+    EXPECT_FALSE(targets.getTarget(0)->hasFD());
+
+    // Goes through the fan out path, but not the CFAM engine
+    Batch batch;
+    for (const auto& t : targets)
+    {
+        batch.write(t, 0x1000, t->getPos());
+    }
+    for (const auto& t : targets)
+    {
+        batch.writeWithMask(t, 0x1001, 0xF0, 0xFF);
+    }
+    batch.submit();
+    batch.check();
+
+    for (const auto& t : targets)
+    {
+        EXPECT_EQ(readReg(t, 0x1000), t->getPos());
+        EXPECT_EQ(readReg(t, 0x1001), 0xF0);
+        EXPECT_EQ(readReg(t, 0x1002), 0);
+    }
+}
+
+TEST(ChipInfoTest, ReadOnce)
+{
+    using namespace openpower::cfam::access;
+    using namespace openpower::cfam::backend;
+    using namespace openpower::cfam::p9;
+
+    std::vector<std::unique_ptr<Target>> chips;
+    chips.push_back(
+        std::make_unique<Target>(2, std::make_unique<MemoryBackend>("id2")));
+    chips.push_back(
+        std::make_unique<Target>(0, std::make_unique<MemoryBackend>("id0")));
+    Targeting targets{std::move(chips)};
+
+    EXPECT_EQ(targets.getTarget(2)->getCFAMPath(), "id2");
+    EXPECT_THROW(targets.getTarget(1), std::runtime_error);
+    EXPECT_THROW(targets.getTarget(3), std::runtime_error);
+
+    const auto& target = targets.getTarget(2);
+    writeReg(target, 0x100A, 0x222D1049);
+
+    auto reads = target->getStats().getCount(
+        openpower::cfam::recorder::Type::read);
+    auto info = getChipInfo(target);
+    EXPECT_EQ(info.chipId, 0x222D1049);
+    EXPECT_EQ(info.type, 0xD1);
+    EXPECT_EQ(info.ec, 0x22);
+    EXPECT_FALSE(info.master);
+
+    // Only read once
+    writeReg(target, 0x100A, P9_DD10_CHIPID);
+    EXPECT_EQ(getChipInfo(target).ec, 0x22);
+    EXPECT_EQ(target->getStats().getCount(
+                  openpower::cfam::recorder::Type::read),
+              reads + 1);
+
+    writeReg(targets.getTarget(0), 0x100A, P9_DD10_CHIPID);
+    info = getChipInfo(targets.getTarget(0));
+    EXPECT_EQ(info.ec, 0x10);
+    EXPECT_TRUE(info.master);
+}
+
+TEST(ParallelTest, ForEach)
+{
+    using namespace openpower::cfam::access;
+    using namespace openpower::cfam::backend;
+
+    std::vector<std::unique_ptr<Target>> chips;
+    for (size_t pos = 0; pos < 4; pos++)
+    {
+        chips.push_back(std::make_unique<Target>(
+            pos, std::make_unique<MemoryBackend>("par" +
+                                                 std::to_string(pos))));
+    }
+    Targeting targets{std::move(chips)};
+
+    // Each one waits for all of them to start, so they only finish
+    // if they run at the same time
+    std::atomic<size_t> started{0};
+    auto result = targets.forEachParallel([&started](const auto& target) {
+        started++;
+        auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while ((started < 4) && (std::chrono::steady_clock::now() < deadline))
+        {
+            std::this_thread::yield();
+        }
+
+        if (target->getPos() == 2)
+        {
+            throw std::runtime_error("chip 2");
+        }
+        writeReg(target, 0x1000, target->getPos());
+    });
+
+    EXPECT_EQ(started, 4);
+    EXPECT_EQ(result.failed, 1);
+    EXPECT_EQ(result.skipped, 0);
+    ASSERT_EQ(result.outcomes.size(), 4);
+    for (size_t pos = 0; pos < 4; pos++)
+    {
+        EXPECT_EQ(result.outcomes[pos].pos, pos);
+        EXPECT_TRUE(result.outcomes[pos].ran);
+        EXPECT_EQ(result.outcomes[pos].error != nullptr, pos == 2);
+    }
+    EXPECT_EQ(readReg(targets.getTarget(3), 0x1000), 3);
+    EXPECT_THROW(result.check(), std::runtime_error);
+
+    // Every target is accounted for when the rest are skipped
+    result = targets.forEachParallel(
+        [](const auto&) { throw std::runtime_error("fail"); },
+        Targeting::Policy::stopOnError);
+    EXPECT_GE(result.failed, 1);
+    EXPECT_EQ(result.failed + result.skipped, 4);
+}
+
+/**
+ * A memory backend whose accesses fail with an errno a number of times
+ */
+class FlakyBackend : public openpower::cfam::backend::MemoryBackend
+{
+  public:
+    FlakyBackend() : MemoryBackend("flaky0") {}
+
+    int read(uint16_t address, uint16_t offset, uint32_t& data) override
+    {
+        return fail() ? error : MemoryBackend::read(address, offset, data);
+    }
+
+    int write(uint16_t address, uint16_t offset, uint32_t data) override
+    {
+        return fail() ? error : MemoryBackend::write(address, offset, data);
+    }
+
+    int failures = 0;
+    int error = EIO;
+
+  private:
+    bool fail()
+    {
+        return failures-- > 0;
+    }
+};
+
+TEST(CFAMRetryTest, Retry)
+{
+    using namespace openpower::cfam::access;
+    using namespace openpower::cfam::retry;
+    using namespace openpower::cfam::stats;
+    using namespace std::chrono;
+
+    auto policy = parse("attempts=4,delay=100,factor=3,max=500,errnos=EIO:16");
+    EXPECT_EQ(policy.attempts, 4);
+    EXPECT_EQ(policy.getDelay(1), microseconds(100));
+    EXPECT_EQ(policy.getDelay(2), microseconds(300));
+    EXPECT_EQ(policy.getDelay(3), microseconds(500));
+    EXPECT_TRUE(policy.isRetryable(EBUSY));
+    EXPECT_FALSE(policy.isRetryable(ETIMEDOUT));
+
+    // Bad settings leave the rest alone
+    auto bad = parse("attempts=0,delay=x,errnos=EIO:EWHAT,bogus", policy);
+    EXPECT_EQ(bad.attempts, 4);
+    EXPECT_EQ(bad.delay, microseconds(100));
+    EXPECT_EQ(bad.errnos, policy.errnos);
+
+    auto saved = getPolicy();
+    setPolicy(policy);
+
+    auto backend = std::make_unique<FlakyBackend>();
+    auto& flaky = *backend;
+    auto target = std::make_unique<Target>(1001, std::move(backend));
+
+    // Absorbed by the retries
+    writeReg(target, 0x1000, 0x12345678);
+    flaky.failures = 3;
+    EXPECT_EQ(readReg(target, 0x1000), 0x12345678);
+    EXPECT_EQ(target->getStats().getRetries(), 3);
+    EXPECT_EQ(target->getStats().getRetryErrnoCount(EIO), 3);
+    EXPECT_EQ(target->getStats().getErrnoCount(EIO), 0);
+    EXPECT_EQ(target->getStats().getErrors(Type::read), 0);
+
+    // Each attempt has a latency sample, the retried ones included
+    uint64_t samples = 0;
+    for (size_t b = 0; b < AccessStats::latencyBuckets; b++)
+    {
+        samples += target->getStats().getLatencyCount(Type::read, b);
+    }
+    EXPECT_EQ(samples, 4);
+
+    // More failures than attempts
+    flaky.failures = 4;
+    auto result = tryReadReg(target, 0x1000);
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error().error, EIO);
+    EXPECT_EQ(target->getStats().getRetries(), 6);
+    EXPECT_EQ(target->getStats().getErrnoCount(EIO), 1);
+
+    // Not a transient failure
+    flaky.failures = 1;
+    flaky.error = ENODEV;
+    EXPECT_FALSE(tryWriteReg(target, 0x1000, 0));
+    EXPECT_EQ(target->getStats().getRetries(), 6);
+
+    // The batch paths retry too
+    flaky.failures = 2;
+    flaky.error = EIO;
+    Batch batch;
+    auto id = batch.read(target, 0x1000);
+    batch.submit();
+    batch.check();
+    EXPECT_EQ(batch.result(id).data, 0x12345678);
+    EXPECT_EQ(target->getStats().getRetries(), 8);
+
+    setPolicy(saved);
+}
+
+TEST(CFAMRetryTest, Run)
+{
+    using namespace openpower::cfam::retry;
+    using namespace std::chrono;
+
+    auto saved = getPolicy();
+    setPolicy(parse("attempts=3,delay=10"));
+
+    // How the libpdbg helpers use it, with their return codes as EIO
+    int failures = 1;
+    std::vector<unsigned> retries;
+    auto access = [&failures]() { return (failures-- > 0) ? EIO : 0; };
+    auto onRetry = [&retries](int err, unsigned retry) {
+        EXPECT_EQ(err, EIO);
+        retries.push_back(retry);
+    };
+
+    EXPECT_EQ(run(access(), access, onRetry), 0);
+    EXPECT_EQ(retries, std::vector<unsigned>{1});
+
+    // Gives up after the attempts, with the last failure
+    failures = 5;
+    retries.clear();
+    EXPECT_EQ(run(access(), access, onRetry), EIO);
+    EXPECT_EQ(retries, (std::vector<unsigned>{1, 2}));
+    EXPECT_EQ(failures, 2);
+
+    // Successes and other failures aren't retried
+    retries.clear();
+    EXPECT_EQ(run(0, access, onRetry), 0);
+    EXPECT_EQ(run(ENODEV, access, onRetry), ENODEV);
+    EXPECT_TRUE(retries.empty());
+
+    setPolicy(saved);
+}
+
+TEST(CFAMAccessWaitTest, WaitForReg)
+{
+    using namespace openpower::cfam::access;
+    using namespace openpower::cfam::backend;
+    using namespace std::chrono;
+
+    auto target = std::make_unique<Target>(
+        0, std::make_unique<MemoryBackend>("memory0"));
+
+    // Already there
+    auto result = waitForReg(target, 0x1000, 0xF0, 0,
+                             steady_clock::now() + milliseconds(100));
+    EXPECT_TRUE(result.matched);
+    EXPECT_EQ(result.polls, 1);
+
+    // Gets there while polling
+    std::thread setter{[&target]() {
+        std::this_thread::sleep_for(milliseconds(20));
+        writeReg(target, 0x1000, 0xA5);
+    }};
+    result = waitForReg(target, 0x1000, 0xF0, 0xA0,
+                        steady_clock::now() + seconds(5));
+    setter.join();
+
+    EXPECT_TRUE(result.matched);
+    EXPECT_EQ(result.data, 0xA5);
+    EXPECT_GT(result.polls, 1);
+    EXPECT_GE(result.elapsed, milliseconds(20));
+
+    // Never gets there
+    result = waitForReg(target, 0x1000, 0xFF, 0,
+                        steady_clock::now() + milliseconds(30));
+    EXPECT_FALSE(result.matched);
+    EXPECT_EQ(result.data, 0xA5);
+    EXPECT_GE(result.elapsed, milliseconds(30));
+}
+
+TEST_F(TargetingTest, Recorder)
+{
+    using namespace openpower::cfam::recorder;
+
+    auto path = _slaveBaseDir / "cfam.rec";
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        Recorder recorder{path, 4};
+        for (uint16_t i = 0; i < 3; i++)
+        {
+            recorder.record(i, Type::write, 0x1000 + i, i, 0, 0, start);
+        }
+    }
+
+    // Appends to the existing ring, which then wraps
+    {
+        Recorder recorder{path, 100};
+        for (uint16_t i = 3; i < 6; i++)
+        {
+            recorder.record(i, Type::writeWithMask, 0x1000 + i, i, 0xFF,
+                            EIO, start);
+        }
+    }
+
+    auto records = load(path);
+    ASSERT_EQ(records.size(), 4);
+    EXPECT_EQ(records[0].address, 0x1002);
+    EXPECT_EQ(records[0].type, Type::write);
+    EXPECT_EQ(records[3].address, 0x1005);
+    EXPECT_EQ(records[3].target, 5);
+    EXPECT_EQ(records[3].mask, 0xFF);
+    EXPECT_EQ(records[3].error, EIO);
+
+    // A record that is still being written is left out
+    {
+        std::fstream file{path, std::ios::binary | std::ios::in |
+                                    std::ios::out};
+        uint64_t unwritten = 0;
+        file.seekp(sizeof(Header) + sizeof(Record) * (5 % 4));
+        file.write(reinterpret_cast<char*>(&unwritten), sizeof(unwritten));
+    }
+
+    records = load(path);
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_EQ(records[2].address, 0x1004);
+}
+
+TEST_F(TargetingTest, Snapshot)
+{
+    using namespace openpower::cfam::access;
+    using namespace openpower::cfam::backend;
+    using namespace openpower::cfam::snapshot;
+
+    std::vector<std::unique_ptr<Target>> targetList;
+    for (size_t pos = 0; pos < 2; pos++)
+    {
+        targetList.push_back(std::make_unique<Target>(
+            pos, std::make_unique<MemoryBackend>("snap" +
+                                                 std::to_string(pos))));
+    }
+    Targeting targets{std::move(targetList)};
+
+    auto config = _slaveBaseDir / "regs";
+    std::ofstream(config) << "# Comment\n0x2800 4\n\n0x100A # Chip ID\n";
+    auto ranges = loadRanges(config);
+    ASSERT_EQ(ranges.size(), 2);
+    EXPECT_EQ(ranges[1].address, 0x100A);
+    EXPECT_EQ(ranges[1].count, 1);
+
+    auto path = (_slaveBaseDir / "cfam.snap").string();
+    save(capture(targets, ranges), path);
+
+    writeReg(targets.getTarget(1), 0x2802, 0x1234);
+    auto after = capture(targets, ranges);
+    ASSERT_EQ(after.entries.size(), 10);
+    EXPECT_EQ(after.entries[0].target, 0);
+    EXPECT_EQ(after.entries[0].address, 0x100A);
+
+    auto changes = diff(load(path), after);
+    ASSERT_EQ(changes.size(), 1);
+    EXPECT_EQ(changes[0].target, 1);
+    EXPECT_EQ(changes[0].address, 0x2802);
+    EXPECT_EQ(changes[0].before->data, 0);
+    EXPECT_EQ(changes[0].after->data, 0x1234);
+
+    std::ofstream(config) << "0xFFFF 2\n";
+    EXPECT_THROW(loadRanges(config), std::runtime_error);
+}
+
+TEST(CFAMRegisterTest, Fields)
+{
+    using namespace openpower::cfam;
+    using namespace openpower::cfam::p9;
+
+    static_assert(P9_SBE_MSG_REGISTER.offset == 0x2824);
+    static_assert(P9_ROOT_CTRL8.offset == makeOffset(0x2918));
+    static_assert(P9_CBS_CS.startSBE.mask == 0x80000000);
+    static_assert(P9_SBE_CTRL_STATUS.seepromSide(1).data == 0x00004000);
+
+    constexpr uint32_t sbeMsg = 0xC0ABCD00;
+    EXPECT_EQ(P9_SBE_MSG_REGISTER.sbeBooted.get(sbeMsg), 1);
+    EXPECT_EQ(P9_SBE_MSG_REGISTER.majorStep.get(sbeMsg), 0xBC);
+    EXPECT_EQ(P9_SBE_MSG_REGISTER.minorStep.get(sbeMsg), 0x34);
+
+    EXPECT_EQ(P9_HB_MBX5_REG.magic.get(0xAA000000), 0xAA);
+    EXPECT_EQ(P9_ROOT_CTRL8.clockMuxSelectOverride.insert(0xFFFFFFF3, 0x3),
+              0xFFFFFFFF);
+
+    auto fields = P9_HB_MBX5_REG.majorStep(0x12) |
+                  P9_HB_MBX5_REG.minorStep(0x34);
+    EXPECT_EQ(fields.data, 0x00001234);
+    EXPECT_EQ(fields.mask, 0x0000FFFF);
+}
+
 void func1()
 {
     std::cout << "Hello\n";
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "config.h"
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#endif
+
+/**
+ * @brief Marks a USDT (user statically defined tracing) probe point
+ *        that bpftrace, perf or SystemTap can attach to.
+ *
+ * An unattached probe is a single nop, and its arguments only have
+ * to be in registers, so probes cost next to nothing on hot paths.
+ * They are in the openpower_proc_control provider, for example
+ * usdt:/usr/bin/openpower-proc-control:openpower_proc_control:
+ * cfam__access__done in bpftrace.
+ *
+ * Does nothing if the build doesn't have sys/sdt.h.
+ *
+ * @param[in] name - The probe name
+ * @param[in] ... - Up to 12 integer or pointer arguments
+ */
+#ifdef HAVE_SYS_SDT_H
+#define OPENPOWER_PROBE(name, ...)                                             \
+    STAP_PROBEV(openpower_proc_control, name __VA_OPT__(, ) __VA_ARGS__)
+#else
+#define OPENPOWER_PROBE(name, ...)                                             \
+    do                                                                         \
+    {                                                                          \
+    } while (0)
+#endif